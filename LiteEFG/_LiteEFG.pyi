@@ -1,22 +1,102 @@
 from __future__ import annotations
+import numpy
 import typing
-__all__ = ['Environment', 'FileEnv', 'Graph', 'GraphNode', 'GraphNodeStatus', 'Vector', 'aggregate', 'argmax', 'argmin', 'backward', 'cat', 'const', 'copy', 'dot', 'euclidean', 'exp', 'forward', 'log', 'max', 'maximum', 'mean', 'min', 'minimum', 'negative_entropy', 'normalize', 'project', 'set_seed', 'sum']
+__all__ = ['BatchedEnv', 'Environment', 'ExploitabilityFuture', 'FileEnv', 'FlatValues', 'Graph', 'GraphNode', 'GraphNodeStatus', 'Kernel', 'LeducEnv', 'NFGEnv', 'PokerEnv', 'ProceduralEnv', 'SparseStrategy', 'StrategyTable', 'UpdateStep', 'Vector', 'aggregate', 'argmax', 'argmin', 'backward', 'cat', 'const', 'copy', 'dot', 'euclidean', 'exp', 'forward', 'kernel', 'kernels', 'log', 'max', 'maximum', 'mean', 'min', 'minimum', 'negative_entropy', 'normalize', 'project', 'read_strategy', 'set_seed', 'sum']
+class BatchedEnv:
+    @staticmethod
+    def _pybind11_conduit_v1_(*args, **kwargs):
+        ...
+    @staticmethod
+    def from_nfg(utility_matrices: list[numpy.ndarray[numpy.float64]], traverse_type: str = 'Enumerate', num_threads: int = 0) -> BatchedEnv:
+        ...
+    def __init__(self, environments: list[Environment], num_threads: int = 0) -> None:
+        ...
+    def __len__(self) -> int:
+        ...
+    def exploitability(self, strategy: GraphNode, type_name: str = 'default') -> list[list[float]]:
+        ...
+    def run(self, schedule: list[UpdateStep], iterations: int, strategy: GraphNode, type_name: str = 'default', eval_every: int = 0, update_best: bool = False, update_strategy_every: int = 1) -> list[list[tuple[int, list[float]]]]:
+        ...
+    def set_graph(self, graph: Graph) -> None:
+        ...
+    def set_seed(self, seed: int) -> None:
+        ...
+    def update(self, strategy: GraphNode, upd_player: int = -1, upd_color: list[int] = [-1], traverse_type: str = 'default') -> None:
+        ...
+    def update_strategy(self, strategy: GraphNode, update_best: bool = False) -> None:
+        ...
+    def utility(self, strategy: GraphNode, type_name: str = 'default') -> list[list[float]]:
+        ...
+    @property
+    def environments(self) -> list[Environment]:
+        ...
 class Environment:
     @staticmethod
     def _pybind11_conduit_v1_(*args, **kwargs):
         ...
+    def cross_play_utility(self, profiles: list[list[str]]) -> list[list[float]]:
+        ...
     @typing.overload
     def exploitability(self, strategy: GraphNode, type_name: str = 'default') -> list[float]:
         ...
     @typing.overload
     def exploitability(self, strategy: list[GraphNode], type_name: str = 'default') -> list[float]:
         ...
+    @typing.overload
+    def exploitability_async(self, strategy: GraphNode, type_name: str = 'default') -> ExploitabilityFuture:
+        ...
+    @typing.overload
+    def exploitability_async(self, strategy: list[GraphNode], type_name: str = 'default') -> ExploitabilityFuture:
+        ...
+    @typing.overload
+    def exploitability_batch(self, strategies: list[GraphNode], type_names: list[str] = ['default']) -> list[list[float]]:
+        ...
+    @typing.overload
+    def exploitability_batch(self, strategies: list[list[GraphNode]], type_names: list[str] = ['default']) -> list[list[float]]:
+        ...
+    def export_strategy(self, path: str, strategy: GraphNode, type_name: str = 'default', threshold: float = 0.0, codec: str = 'default', num_threads: int = 0) -> None:
+        ...
+    def freeze_strategy(self, name: str, strategy: GraphNode, type_name: str = 'default') -> None:
+        ...
+    def get_flat_strategy(self, player: int, strategy: GraphNode, type_name: str = 'default') -> FlatValues:
+        ...
+    def get_flat_value(self, player: int, node: GraphNode) -> FlatValues:
+        ...
+    def get_infoset_names(self, player: int, indices: list[int] = []) -> list[str]:
+        ...
+    def get_sparse_strategy(self, player: int, strategy: GraphNode, type_name: str = 'default', threshold: float = 0.0) -> SparseStrategy:
+        ...
     def get_strategy(self, player: int, strategy: GraphNode, type_name: str = 'default') -> list[tuple[str, list[float]]]:
         ...
     def get_value(self, player: int, node: GraphNode) -> list[tuple[str, list[float]]]:
         ...
+    def get_value_array(self, player: int, node: GraphNode) -> tuple[numpy.ndarray[numpy.float64], numpy.ndarray[numpy.int32]]:
+        ...
+    def load(self, path: str) -> None:
+        ...
+    def load_strategy(self, name: str, player: int, strategy: list[float]) -> None:
+        ...
+    def matchup_matrix(self, row_names: list[str], col_names: list[str]) -> list[list[list[float]]]:
+        ...
+    @typing.overload
+    def run(self, schedule: list[UpdateStep], iterations: int, strategy: GraphNode, type_name: str = 'default', eval_every: int = 0, update_best: bool = False, update_strategy_every: int = 1) -> list[tuple[int, list[float]]]:
+        ...
+    @typing.overload
+    def run(self, schedule: list[UpdateStep], iterations: int, strategy: list[GraphNode], type_name: str = 'default', eval_every: int = 0, update_best: bool = False, update_strategy_every: int = 1) -> list[tuple[int, list[float]]]:
+        ...
+    def save(self, path: str) -> int:
+        ...
+    def set_best_iterate_tracking(self, eval_freq: int, num_candidates: int = 0) -> None:
+        ...
+    def set_compensated_summation(self, is_compensated: bool = True) -> None:
+        ...
     def set_graph(self, graph: Graph) -> None:
         ...
+    def set_sparse_value(self, player: int, node: GraphNode, values: SparseStrategy) -> None:
+        ...
+    @typing.overload
+    def set_value(self, player: int, node: GraphNode, values: numpy.ndarray) -> None:
+        ...
     @typing.overload
     def set_value(self, player: int, node: GraphNode, values: list[list[float]]) -> None:
         ...
@@ -37,16 +117,56 @@ class Environment:
     @typing.overload
     def utility(self, strategy: list[GraphNode], type_name: str = 'default') -> list[float]:
         ...
+    @typing.overload
+    def utility_batch(self, strategies: list[GraphNode], type_names: list[str] = ['default']) -> list[list[float]]:
+        ...
+    @typing.overload
+    def utility_batch(self, strategies: list[list[GraphNode]], type_names: list[str] = ['default']) -> list[list[float]]:
+        ...
+    @property
+    def run_iterations(self) -> int:
+        ...
+    @run_iterations.setter
+    def run_iterations(self, arg1: int) -> None:
+        ...
+class ExploitabilityFuture:
+    @staticmethod
+    def _pybind11_conduit_v1_(*args, **kwargs):
+        ...
+    def done(self) -> bool:
+        ...
+    def result(self) -> list[float]:
+        ...
 class FileEnv(Environment):
     @staticmethod
     def _pybind11_conduit_v1_(*args, **kwargs):
         ...
-    def __init__(self, file_name: str, traverse_type: str = 'Enumerate') -> None:
+    @typing.overload
+    def __init__(self, file_name: str, traverse_type: str = 'Enumerate', num_threads: int = 0, keep_infoset_names: bool = True) -> None:
+        ...
+    @typing.overload
+    def __init__(self, num_players: int, players: numpy.ndarray[numpy.int32], infosets: numpy.ndarray[numpy.int32], next_ptr: numpy.ndarray[numpy.int32], next: numpy.ndarray[numpy.int32], chance: numpy.ndarray[numpy.float64], payoffs: numpy.ndarray[numpy.float64], infoset_names: list[list[str]] = [], traverse_type: str = 'Enumerate') -> None:
+        ...
+    def save_binary(self, file_name: str) -> None:
+        ...
+class FlatValues:
+    @staticmethod
+    def _pybind11_conduit_v1_(*args, **kwargs):
+        ...
+    @property
+    def indptr(self) -> numpy.ndarray[numpy.int32]:
+        ...
+    @property
+    def values(self) -> numpy.ndarray[numpy.float64]:
         ...
 class Graph:
     @staticmethod
     def _pybind11_conduit_v1_(*args, **kwargs):
         ...
+    def __enter__(self) -> Graph:
+        ...
+    def __exit__(self, *args) -> None:
+        ...
     def __init__(self) -> None:
         ...
     @property
@@ -167,6 +287,96 @@ class GraphNodeStatus:
         ...
     def __init__(self) -> None:
         ...
+class Kernel:
+    @staticmethod
+    def _pybind11_conduit_v1_(*args, **kwargs):
+        ...
+    @property
+    def alternating(self) -> bool:
+        ...
+    @property
+    def name(self) -> str:
+        ...
+    @property
+    def nodes(self) -> dict[str, GraphNode]:
+        ...
+class LeducEnv(Environment):
+    @staticmethod
+    def _pybind11_conduit_v1_(*args, **kwargs):
+        ...
+    def __init__(self, num_players: int = 2, num_ranks: int = 3, num_copies: int = 2, traverse_type: str = 'Enumerate') -> None:
+        ...
+class NFGEnv(Environment):
+    @staticmethod
+    def _pybind11_conduit_v1_(*args, **kwargs):
+        ...
+    def __init__(self, utility_matrices: list[numpy.ndarray[numpy.float64]], traverse_type: str = 'Enumerate') -> None:
+        ...
+class PokerEnv(ProceduralEnv):
+    @staticmethod
+    def _pybind11_conduit_v1_(*args, **kwargs):
+        ...
+    def __init__(self, num_players: int = 2, num_ranks: int = 3, num_suits: int = 2, hole_cards: int = 1, board_cards: list[int] = [0, 1], raise_sizes: list[list[int]] = [[1], [2]], max_raises: list[int] = [2, 2], ante: int = 1, suit_isomorphism: bool = True, traverse_type: str = 'Enumerate') -> None:
+        ...
+class ProceduralEnv(Environment):
+    @staticmethod
+    def _pybind11_conduit_v1_(*args, **kwargs):
+        ...
+class SparseStrategy:
+    @staticmethod
+    def _pybind11_conduit_v1_(*args, **kwargs):
+        ...
+    @typing.overload
+    def __init__(self) -> None:
+        ...
+    @typing.overload
+    def __init__(self, indptr: numpy.ndarray[numpy.int32], indices: numpy.ndarray[numpy.int32], values: numpy.ndarray[numpy.float64]) -> None:
+        ...
+    @property
+    def indices(self) -> numpy.ndarray[numpy.int32]:
+        ...
+    @property
+    def indptr(self) -> numpy.ndarray[numpy.int32]:
+        ...
+    @property
+    def values(self) -> numpy.ndarray[numpy.float64]:
+        ...
+class StrategyTable:
+    @staticmethod
+    def _pybind11_conduit_v1_(*args, **kwargs):
+        ...
+    def __len__(self) -> int:
+        ...
+    def names(self) -> list[str]:
+        ...
+    @property
+    def action(self) -> numpy.ndarray[numpy.int32]:
+        ...
+    @property
+    def indptr(self) -> numpy.ndarray[numpy.int64]:
+        ...
+    @property
+    def infoset(self) -> numpy.ndarray[numpy.int32]:
+        ...
+    @property
+    def player(self) -> numpy.ndarray[numpy.int32]:
+        ...
+    @property
+    def probability(self) -> numpy.ndarray[numpy.float64]:
+        ...
+    @property
+    def row_infoset(self) -> numpy.ndarray[numpy.int32]:
+        ...
+class UpdateStep:
+    @staticmethod
+    def _pybind11_conduit_v1_(*args, **kwargs):
+        ...
+    @typing.overload
+    def __init__(self, strategy: GraphNode, upd_player: int = -1, upd_color: list[int] = [-1], traverse_type: str = 'default', period: int = 1, phases: list[int] = [0], start: int = 1, stop: int = 0) -> None:
+        ...
+    @typing.overload
+    def __init__(self, strategies: list[GraphNode], upd_player: int = -1, upd_color: list[int] = [-1], traverse_type: str = 'default', period: int = 1, phases: list[int] = [0], start: int = 1, stop: int = 0) -> None:
+        ...
 class Vector:
     @staticmethod
     def _pybind11_conduit_v1_(*args, **kwargs):
@@ -213,6 +423,10 @@ def euclidean(arg0: GraphNode) -> GraphNode:
     ...
 def exp(arg0: GraphNode) -> GraphNode:
     ...
+def kernel(graph: Graph, name: str, params: dict[str, float | str] = {}) -> Kernel:
+    ...
+def kernels() -> list[str]:
+    ...
 def log(arg0: GraphNode) -> GraphNode:
     ...
 def max(arg0: GraphNode) -> GraphNode:
@@ -235,6 +449,8 @@ def project(arg0: GraphNode, distance: str, gamma: int | float | GraphNode = 0.0
 @typing.overload
 def project(arg0: GraphNode, distance: str, gamma: int | float | GraphNode, mu: GraphNode) -> GraphNode:
     ...
+def read_strategy(path: str, num_threads: int = 0) -> StrategyTable:
+    ...
 def set_seed(seed: int) -> None:
     ...
 def sum(arg0: GraphNode) -> GraphNode:
@@ -1,8 +1,19 @@
+from LiteEFG._LiteEFG import BatchedEnv
 from LiteEFG._LiteEFG import Environment
+from LiteEFG._LiteEFG import ExploitabilityFuture
 from LiteEFG._LiteEFG import FileEnv
+from LiteEFG._LiteEFG import FlatValues
 from LiteEFG._LiteEFG import Graph
 from LiteEFG._LiteEFG import GraphNode
 from LiteEFG._LiteEFG import GraphNodeStatus
+from LiteEFG._LiteEFG import Kernel
+from LiteEFG._LiteEFG import LeducEnv
+from LiteEFG._LiteEFG import NFGEnv
+from LiteEFG._LiteEFG import PokerEnv
+from LiteEFG._LiteEFG import ProceduralEnv
+from LiteEFG._LiteEFG import SparseStrategy
+from LiteEFG._LiteEFG import StrategyTable
+from LiteEFG._LiteEFG import UpdateStep
 from LiteEFG._LiteEFG import Vector
 from LiteEFG._LiteEFG import aggregate
 from LiteEFG._LiteEFG import argmax
@@ -15,6 +26,8 @@ from LiteEFG._LiteEFG import dot
 from LiteEFG._LiteEFG import euclidean
 from LiteEFG._LiteEFG import exp
 from LiteEFG._LiteEFG import forward
+from LiteEFG._LiteEFG import kernel
+from LiteEFG._LiteEFG import kernels
 from LiteEFG._LiteEFG import log
 from LiteEFG._LiteEFG import max
 from LiteEFG._LiteEFG import maximum
@@ -24,6 +37,7 @@ from LiteEFG._LiteEFG import minimum
 from LiteEFG._LiteEFG import negative_entropy
 from LiteEFG._LiteEFG import normalize
 from LiteEFG._LiteEFG import project
+from LiteEFG._LiteEFG import read_strategy
 from LiteEFG._LiteEFG import set_seed
 from LiteEFG._LiteEFG import sum
 from LiteEFG.src.Environment.OpenSpiel.OpenSpielToGameFile import OpenSpielEnv
@@ -32,4 +46,4 @@ from . import _LiteEFG
 from . import baselines
 from . import random
 from . import src
-__all__ = ['Environment', 'FileEnv', 'Graph', 'GraphNode', 'GraphNodeStatus', 'OpenSpielEnv', 'Vector', 'aggregate', 'argmax', 'argmin', 'backward', 'baselines', 'cat', 'const', 'copy', 'dot', 'euclidean', 'exp', 'forward', 'log', 'max', 'maximum', 'mean', 'min', 'minimum', 'negative_entropy', 'normalize', 'project', 'random', 'set_seed', 'src', 'sum']
+__all__ = ['BatchedEnv', 'Environment', 'ExploitabilityFuture', 'FileEnv', 'FlatValues', 'Graph', 'GraphNode', 'GraphNodeStatus', 'Kernel', 'LeducEnv', 'NFGEnv', 'OpenSpielEnv', 'PokerEnv', 'ProceduralEnv', 'SparseStrategy', 'StrategyTable', 'UpdateStep', 'Vector', 'aggregate', 'argmax', 'argmin', 'backward', 'baselines', 'cat', 'const', 'copy', 'dot', 'euclidean', 'exp', 'forward', 'kernel', 'kernels', 'log', 'max', 'maximum', 'mean', 'min', 'minimum', 'negative_entropy', 'normalize', 'project', 'random', 'read_strategy', 'set_seed', 'src', 'sum']
@@ -36,6 +36,9 @@ class graph(_baseline):
     
     def update_graph(self, env : LiteEFG.Environment) -> None:
         env.update(self.strategy)
+
+    def update_schedule(self) -> list:
+        return [LiteEFG.UpdateStep(self.strategy)]
     
     def current_strategy(self) -> LiteEFG.GraphNode:
         return self.strategy
@@ -74,6 +74,10 @@ class graph(_baseline):
         else:
             env.update(self.u, upd_color=[0])
 
+    def update_schedule(self) -> list:
+        return [LiteEFG.UpdateStep(self.u, upd_color=[0, 1], period=self.inner_epoch, phases=[0]),
+                LiteEFG.UpdateStep(self.u, upd_color=[0], period=self.inner_epoch, phases=range(1, self.inner_epoch))]
+
     
     def current_strategy(self) -> LiteEFG.GraphNode:
         return self.bar_u
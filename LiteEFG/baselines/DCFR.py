@@ -59,6 +59,9 @@ class graph(_baseline):
     def update_graph(self, env : LiteEFG.Environment) -> None:
         env.update(self.strategy, upd_player=1)
         env.update(self.strategy, upd_player=2)
+
+    def update_schedule(self) -> list:
+        return [LiteEFG.UpdateStep(self.strategy, upd_player=1), LiteEFG.UpdateStep(self.strategy, upd_player=2)]
     
     def current_strategy(self, type_name="last-iterate"):
         assert(type_name in ["last-iterate", "average-iterate"])
@@ -70,6 +70,9 @@ class graph(_baseline):
     def update_graph(self, env : LiteEFG.Environment) -> None:
         env.update(self.u)
 
+    def update_schedule(self) -> list:
+        return [LiteEFG.UpdateStep(self.u)]
+
     def current_strategy(self) -> LiteEFG.GraphNode:
         return self.u
 
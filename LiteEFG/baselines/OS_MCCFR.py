@@ -64,6 +64,10 @@ class graph(_baseline):
         env.update([self.explore_strategy, self.strategy], upd_player=1)
         env.update([self.prev_strategy, self.explore_strategy], upd_player=2)
 
+    def update_schedule(self) -> list:
+        return [LiteEFG.UpdateStep([self.explore_strategy, self.strategy], upd_player=1),
+                LiteEFG.UpdateStep([self.prev_strategy, self.explore_strategy], upd_player=2)]
+
     def current_strategy(self) -> LiteEFG.GraphNode:
         return self.strategy
 
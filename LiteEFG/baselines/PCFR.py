@@ -33,6 +33,9 @@ class graph(_baseline):
         env.update(self.strategy, upd_player=1)
         env.update(self.strategy, upd_player=2)
 
+    def update_schedule(self) -> list:
+        return [LiteEFG.UpdateStep(self.strategy, upd_player=1), LiteEFG.UpdateStep(self.strategy, upd_player=2)]
+
     def current_strategy(self) -> LiteEFG.GraphNode:
         return self.strategy
 
@@ -103,6 +103,11 @@ class graph(_baseline):
             return
         env.update(self.u, upd_color=[0, 1, 2]) if self.timestep % self.shrink_iter == 0 else env.update(self.u, upd_color=[0, 2])
 
+    def update_schedule(self) -> list:
+        return [LiteEFG.UpdateStep(self.u, upd_color=[0], stop=1),
+                LiteEFG.UpdateStep(self.u, upd_color=[0, 1, 2], period=self.shrink_iter, phases=[0], start=2),
+                LiteEFG.UpdateStep(self.u, upd_color=[0, 2], period=self.shrink_iter, phases=range(1, self.shrink_iter), start=2)]
+
     def current_strategy(self) -> LiteEFG.GraphNode:
         return self.u
 
@@ -14,3 +14,5 @@ class graph(LiteEFG.baselines.baseline._baseline):
         ...
     def update_graph(self, env: LiteEFG._LiteEFG.Environment) -> None:
         ...
+    def update_schedule(self) -> list[LiteEFG._LiteEFG.UpdateStep]:
+        ...
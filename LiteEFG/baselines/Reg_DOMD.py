@@ -105,6 +105,10 @@ class graph(_baseline):
         self.timestep += 1
         env.update(self.u, upd_color=[0, 1]) if self.timestep % self.shrink_iter == 0 else env.update(self.u, upd_color=[0])
 
+    def update_schedule(self) -> list:
+        return [LiteEFG.UpdateStep(self.u, upd_color=[0, 1], period=self.shrink_iter, phases=[0]),
+                LiteEFG.UpdateStep(self.u, upd_color=[0], period=self.shrink_iter, phases=range(1, self.shrink_iter))]
+
     def current_strategy(self) -> LiteEFG.GraphNode:
         return self.u
 
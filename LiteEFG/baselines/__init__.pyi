@@ -15,6 +15,7 @@ from . import QFR
 from . import Reg_CFR
 from . import Reg_DOMD
 from . import baseline
-__all__ = ['Balanced_FTRL', 'Balanced_OMD', 'CFR', 'CFRplus', 'CMD', 'DCFR', 'DOMD', 'FTPL', 'IXOMD', 'MMD', 'OS_MCCFR', 'PCFR', 'QFR', 'Reg_CFR', 'Reg_DOMD', 'baseline']
+from . import native
+__all__ = ['Balanced_FTRL', 'Balanced_OMD', 'CFR', 'CFRplus', 'CMD', 'DCFR', 'DOMD', 'FTPL', 'IXOMD', 'MMD', 'OS_MCCFR', 'PCFR', 'QFR', 'Reg_CFR', 'Reg_DOMD', 'baseline', 'native']
 def _import_all_modules():
     ...
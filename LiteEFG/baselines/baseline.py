@@ -15,3 +15,10 @@ class _baseline(LiteEFG.Graph):
             update the graph.
         """
         raise NotImplementedError("update_graph method should be implemented by the baseline")
+
+    def update_schedule(self) -> list:
+        """
+            return the list of LiteEFG.UpdateStep doing the same updates as update_graph, so that env.run can train without returning to Python.
+            None if update_graph needs Python at every iteration.
+        """
+        return None
@@ -16,3 +16,10 @@ class _baseline(LiteEFG._LiteEFG.Graph):
                     update the graph.
                 
         """
+    def update_schedule(self) -> list:
+        """
+        
+                    return the list of LiteEFG.UpdateStep doing the same updates as update_graph, so that env.run can train without returning to Python.
+                    None if update_graph needs Python at every iteration.
+                
+        """
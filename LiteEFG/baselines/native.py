@@ -0,0 +1,86 @@
+#######################################################
+# Native baselines
+# CFR, CFRplus, DCFR, PCFR, MMD and QFR computed by fused C++ kernels, one node per infoset instead of
+# the graph expressions. With the same parameters, they give the same iterates as the graphs of the same name.
+# CMD, DOMD, FTPL, IXOMD, OS_MCCFR, Reg_* and Balanced_* have no native kernels and only exist as graphs.
+#######################################################
+
+import LiteEFG
+from LiteEFG.baselines.baseline import _baseline
+
+class graph(_baseline):
+    def __init__(self, name="CFR", **params):
+        super().__init__()
+
+        self.name = name
+        self.kernel = LiteEFG.kernel(self, name, params)
+        self.strategy = self.kernel.nodes["strategy"]
+        self.players = [1, 2] if self.kernel.alternating else [-1]
+
+        print("===============Graph is ready for native %s===============" % name)
+        print(", ".join("%s: %s" % (key, val) for key, val in params.items()))
+        print("====================================================\n")
+
+    def update_graph(self, env : LiteEFG.Environment) -> None:
+        for player in self.players:
+            env.update(self.strategy, upd_player=player)
+
+    def update_schedule(self) -> list:
+        return [LiteEFG.UpdateStep(self.strategy, upd_player=player) for player in self.players]
+
+    def current_strategy(self, type_name="last-iterate") -> LiteEFG.GraphNode:
+        # same as DCFR.graph, whose last iterate is the discounted average strategy
+        if "average_strategy" in self.kernel.nodes and type_name != "average-iterate":
+            return self.kernel.nodes["average_strategy"]
+        return self.strategy
+
+def compare(name, make_env, iterations=100, type_name="last-iterate", **params) -> float:
+    """
+        train the native baseline and the graph of LiteEFG.baselines.<name> with the same parameters,
+        each on the environment returned by make_env(), and return the largest difference of their exploitabilities.
+    """
+    import importlib
+    graphs = [graph(name, **params), importlib.import_module("LiteEFG.baselines." + name).graph(**params)]
+
+    traces = []
+    for g in graphs:
+        env = make_env()
+        env.set_graph(g)
+        LiteEFG.set_seed(0)
+        traces.append(env.run(g.update_schedule(), iterations, g.current_strategy(), type_name, eval_every=1))
+
+    return max(abs(x - y) for (_, native), (_, reference) in zip(*traces) for x, y in zip(native, reference))
+
+convergence_types = {"CFR": "avg-iterate", "CFRplus": "linear-avg-iterate", "PCFR": "linear-avg-iterate",
+                     "DCFR": "last-iterate", "MMD": "default", "QFR": "default"}
+
+if __name__ == "__main__":
+    import argparse
+
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--algorithm", type=str, choices=LiteEFG.kernels(), default="CFR")
+    parser.add_argument("--game", type=str, default="leduc_poker")
+    parser.add_argument("--traverse_type", type=str, choices=["Enumerate", "External", "Outcome"], default="Enumerate")
+    parser.add_argument("--iter", type=int, default=100000)
+    parser.add_argument("--print_freq", type=int, default=1000)
+    parser.add_argument("--params", help="parameters of the algorithm, e.g. eta=0.1 regularizer=Euclidean", nargs="*", default=[])
+    parser.add_argument("--check", help="compare with the graph baseline of the same name instead of training", action="store_true")
+
+    args = parser.parse_args()
+
+    params = {}
+    for param in args.params:
+        key, val = param.split("=", 1)
+        try:
+            params[key] = float(val)
+        except ValueError:
+            params[key] = val
+
+    if args.check:
+        import pyspiel
+        game = pyspiel.load_game(args.game)
+        make_env = lambda: LiteEFG.OpenSpielEnv(game, traverse_type=args.traverse_type, regenerate=False)
+        print("Largest difference of exploitability: %.3e" % compare(args.algorithm, make_env, args.iter, type_name=convergence_types[args.algorithm], **params))
+    else:
+        from utils import train
+        train(graph(args.algorithm, **params), args.traverse_type, convergence_types[args.algorithm], args.iter, args.print_freq, args.game)
@@ -0,0 +1,16 @@
+import LiteEFG as LiteEFG
+from LiteEFG.baselines.baseline import _baseline
+from __future__ import annotations
+__all__ = ['LiteEFG', 'compare', 'convergence_types', 'graph']
+class graph(LiteEFG.baselines.baseline._baseline):
+    def __init__(self, name = 'CFR', **params):
+        ...
+    def current_strategy(self, type_name = 'last-iterate') -> LiteEFG._LiteEFG.GraphNode:
+        ...
+    def update_graph(self, env: LiteEFG._LiteEFG.Environment) -> None:
+        ...
+    def update_schedule(self) -> list[LiteEFG._LiteEFG.UpdateStep]:
+        ...
+def compare(name, make_env, iterations = 100, type_name = 'last-iterate', **params) -> float:
+    ...
+convergence_types: dict = {'CFR': 'avg-iterate', 'CFRplus': 'linear-avg-iterate', 'PCFR': 'linear-avg-iterate', 'DCFR': 'last-iterate', 'MMD': 'default', 'QFR': 'default'}
@@ -1,7 +1,6 @@
 import LiteEFG
 from tqdm import tqdm
 import pyspiel
-import csv
 
 def train(graph, traverse_type, convergence_type, iter, print_freq, game_env="leduc_poker", output_strategy=False):
     game = pyspiel.load_game(game_env)
@@ -10,22 +9,45 @@ def train(graph, traverse_type, convergence_type, iter, print_freq, game_env="le
 
     pbar = tqdm(total=iter)
     best_exp = 1e9
+    pending = None # the last evaluation, computed in the background while training continues
 
-    for i in range(iter):
-        graph.update_graph(env)
-        env.update_strategy(graph.current_strategy(), update_best=(convergence_type == "best-iterate"))
-            
-        if i % print_freq == 0:
-            exploitability = sum(env.exploitability(graph.current_strategy(), convergence_type))
-            best_exp = min(best_exp, exploitability)
-            pbar.set_description(f'Exploitability: {exploitability:.8f}, Best: {best_exp:.8f}')
-            pbar.update(print_freq)
+    def report(future):
+        nonlocal best_exp
+        exploitability = sum(future.result())
+        best_exp = min(best_exp, exploitability)
+        pbar.set_description(f'Exploitability: {exploitability:.8f}, Best: {best_exp:.8f}')
+        pbar.update(print_freq)
+
+    schedule = graph.update_schedule()
+    if schedule is not None:
+        # the iterations between two evaluations run in C++, while the previous evaluation runs on another thread
+        # the Python counter of update_graph (DCFR.timestep is a graph node instead) is the iteration count of env.run while it runs
+        has_counter = isinstance(getattr(graph, "timestep", None), int)
+        for i in range(0, iter, print_freq):
+            if has_counter:
+                env.run_iterations = graph.timestep
+            env.run(schedule, min(print_freq, iter - i), graph.current_strategy(), update_best=(convergence_type == "best-iterate"))
+            if has_counter:
+                graph.timestep = env.run_iterations
+            if pending is not None:
+                report(pending)
+            pending = env.exploitability_async(graph.current_strategy(), convergence_type)
+    else:
+        for i in range(iter):
+            graph.update_graph(env)
+            env.update_strategy(graph.current_strategy(), update_best=(convergence_type == "best-iterate"))
+                
+            if i % print_freq == 0:
+                if pending is not None:
+                    report(pending)
+                pending = env.exploitability_async(graph.current_strategy(), convergence_type)
+
+    if pending is not None:
+        report(pending)
 
     if output_strategy:
-        _, df_list = env.get_strategy(graph.current_strategy(), "avg-iterate")
-        for i, df in enumerate(df_list):
-            df['Infoset'] = df['Infoset'].apply(lambda x: x.replace('\n', '\\n'))
-            df.to_csv("strategy_" + str(i) + ".csv", quoting=csv.QUOTE_MINIMAL, quotechar='"')
+        # columnar binary file written from C++, read back with LiteEFG.read_strategy("strategy.lefg")
+        env.export_strategy("strategy.lefg", graph.current_strategy(), "avg-iterate")
 
 def test():
     import sys
@@ -2,16 +2,50 @@
 
 #include "Basic/Constants.h"
 
+#include <algorithm>
+#include <utility>
+#include <atomic>
+#include <charconv>
 #include <cmath>
+#include <cstdlib>
+#include <exception>
 #include <stdexcept>
+#include <system_error>
+#include <thread>
 
-std::default_random_engine Basic::generator;
-std::uniform_real_distribution<double> Basic::uniform(0.0,1.0);
-std::normal_distribution<double> Basic::normal(0.0,1.0);
-std::exponential_distribution<double> Basic::exponential(1.0);
+static std::atomic<unsigned int> next_thread_seed{std::default_random_engine::default_seed};
+
+thread_local std::default_random_engine Basic::generator(next_thread_seed++);
+thread_local std::uniform_real_distribution<double> Basic::uniform(0.0,1.0);
+thread_local std::normal_distribution<double> Basic::normal(0.0,1.0);
+thread_local std::exponential_distribution<double> Basic::exponential(1.0);
 
 void Basic::SetSeed(const unsigned int& seed){
+    /*
+        Seed the generator of the calling thread and reset its distributions, so the draws after SetSeed only depend on seed
+        Threads that already sampled keep their streams, and threads that draw their first random number later are seeded with seed+1, seed+2, ...
+        in the order they start sampling. For reproducible results across threads, call SetSeed in each thread before it samples
+        BatchedEnvironment does not depend on this, since each of its games has its own RandomState
+    */
     generator.seed(seed);
+    uniform.reset();
+    normal.reset();
+    exponential.reset();
+    next_thread_seed = seed + 1;
+}
+
+void Basic::RandomState::Seed(const unsigned int& seed){
+    generator.seed(seed);
+    uniform.reset();
+    normal.reset();
+    exponential.reset();
+}
+
+void Basic::RandomState::SwapWithThread(){
+    std::swap(generator, Basic::generator);
+    std::swap(uniform, Basic::uniform);
+    std::swap(normal, Basic::normal);
+    std::swap(exponential, Basic::exponential);
 }
 
 double Basic::Sqr(const double& x){
@@ -52,4 +86,70 @@ std::string Basic::GetSlice(const std::string& a, const int& start, const char&
     int i = start;
     while(i < a.size() && a[i] != end) i++;
     return a.substr(start, i-start);
+}
+
+std::string_view Basic::GetSlice(const std::string_view& a, const int& start, const char& end){
+    int i = start;
+    while(i < a.size() && a[i] != end) i++;
+    return a.substr(start, i-start);
+}
+
+int Basic::ParseInt(const std::string_view& a){
+    int value = 0;
+    auto result = std::from_chars(a.data(), a.data() + a.size(), value);
+    if(result.ec != std::errc() || result.ptr != a.data() + a.size())
+        throw std::invalid_argument("Cannot parse \"" + std::string(a) + "\" as an integer");
+    return value;
+}
+
+double Basic::ParseDouble(const std::string_view& a){
+    /*
+        std::from_chars for double is not available in every standard library (e.g. older libc++),
+        in which case fall back to strtod on a null-terminated copy
+    */
+    double value = 0.0;
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    const char* first = a.data() + (a.size() > 0 && a[0] == '+'); // from_chars does not accept a leading '+'
+    auto result = std::from_chars(first, a.data() + a.size(), value);
+    if(result.ec != std::errc() || result.ptr != a.data() + a.size())
+        throw std::invalid_argument("Cannot parse \"" + std::string(a) + "\" as a number");
+#else
+    std::string buffer(a);
+    char* end = NULL;
+    value = std::strtod(buffer.c_str(), &end);
+    if(buffer.empty() || end != buffer.c_str() + buffer.size())
+        throw std::invalid_argument("Cannot parse \"" + buffer + "\" as a number");
+#endif
+    return value;
+}
+
+int Basic::GetNumThreads(const int& num_threads){
+    // num_threads <= 0 means using all hardware threads
+    if(num_threads > 0) return num_threads;
+    return std::max(1, (int)std::thread::hardware_concurrency());
+}
+
+void Basic::ParallelFor(const int& num_threads, const std::function<void(const int&)>& func){
+    /*
+        Run func(0), ..., func(num_threads-1) concurrently, func(0) runs on the calling thread
+        The first exception thrown by any of them is rethrown after all threads finish
+    */
+    if(num_threads <= 1){
+        func(0);
+        return;
+    }
+    std::vector<std::thread> threads;
+    std::vector<std::exception_ptr> errors(num_threads);
+    auto run = [&](const int& idx){
+        try{
+            func(idx);
+        } catch(...){
+            errors[idx] = std::current_exception();
+        }
+    };
+    for(int i=1; i<num_threads; ++i) threads.emplace_back(run, i);
+    run(0);
+    for(auto& thread : threads) thread.join();
+    for(auto& error : errors)
+        if(error) std::rethrow_exception(error);
 }
\ No newline at end of file
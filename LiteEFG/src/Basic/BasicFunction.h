@@ -3,26 +3,69 @@
 
 #include "Data/Vector.h"
 
+#include <cmath>
+#include <functional>
 #include <vector>
 #include <random>
 #include <string>
+#include <string_view>
 
 namespace Basic{
 
-extern std::default_random_engine generator;
-extern std::uniform_real_distribution<double> uniform;
-extern std::normal_distribution<double> normal;
-extern std::exponential_distribution<double> exponential;
+// One generator per thread, so that environments used from different threads do not share random state
+extern thread_local std::default_random_engine generator;
+extern thread_local std::uniform_real_distribution<double> uniform;
+extern thread_local std::normal_distribution<double> normal;
+extern thread_local std::exponential_distribution<double> exponential;
 
 void SetSeed(const unsigned int& seed);
 
+class RandomState{
+public:
+    /*
+        Generator and distributions that can be swapped with those of the calling thread, e.g. one per game of BatchedEnvironment
+        The distributions are part of the state, since normal_distribution keeps the second variate of each pair it generates
+    */
+    std::default_random_engine generator;
+    std::uniform_real_distribution<double> uniform{0.0, 1.0};
+    std::normal_distribution<double> normal{0.0, 1.0};
+    std::exponential_distribution<double> exponential{1.0};
+
+    void Seed(const unsigned int& seed);
+    void SwapWithThread();
+};
+
 double Sqr(const double& x);
 
 int Sample(const std::vector<double>& probs);
 int Sample(Vector* probs);
 
+inline void NeumaierAdd(double& sum, double& compensation, const double& x){
+    /*
+        Compensated summation: sum + compensation tracks the exact sum with the rounding error of each addition kept in compensation
+        Branch-free so that loops calling it can be vectorized. Defined in the header to be inlined into hot loops
+    */
+    double t = sum + x;
+    compensation += (std::fabs(sum) >= std::fabs(x)) ? (sum - t) + x : (x - t) + sum;
+    sum = t;
+}
+
+inline void NeumaierMulAdd(double& sum, double& compensation, const double& a, const double& b){
+    // Add a * b, where the rounding error of the product is recovered exactly by fma
+    double p = a * b;
+    compensation += std::fma(a, b, -p);
+    NeumaierAdd(sum, compensation, p);
+}
+
 bool IsPrefixString(const std::string& a, const std::string& prefix);
 std::string GetSlice(const std::string& a, const int& start, const char& end);
+std::string_view GetSlice(const std::string_view& a, const int& start, const char& end);
+
+int GetNumThreads(const int& num_threads);
+void ParallelFor(const int& num_threads, const std::function<void(const int&)>& func);
+
+int ParseInt(const std::string_view& a);
+double ParseDouble(const std::string_view& a);
 
 };
 
@@ -1,73 +1,267 @@
 #include "Basic/FileReader.h"
 
+#include "Basic/BasicFunction.h"
+
+#include <algorithm>
+#include <climits>
 #include <cstdio>
 #include <cstdlib>
-#include <fstream>
 #include <stdexcept>
 
-FileReader::FileReader(const std::string& file_name_) {
-    file = fopen(file_name_.c_str(), "r");
-    if(file == NULL) throw std::runtime_error("File " + file_name_ + " not found");
-    cursor = file_end = NULL;
-}
+#ifdef LITEEFG_WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef LITEEFG_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
-char FileReader::Read(){
-    if(cursor == file_end){
-        cursor = buffer;
-        file_end = buffer + fread(buffer, 1, MAX_BUFFER_SIZE, file);
-        if(cursor == file_end) return EOF; // End of file
+FileReader::FileReader(const std::string& file_name_, const int& num_threads_) : FileCursor(NULL, NULL), num_threads(num_threads_) {
+    data = mapping = NULL;
+    file_size = mapping_size = 0;
+#ifdef _WIN32
+    file_handle = CreateFileA(file_name_.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    mapping_handle = NULL;
+    if(file_handle == INVALID_HANDLE_VALUE) throw std::runtime_error("File " + file_name_ + " not found");
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(file_handle, &size)){
+        ReleaseMapping();
+        throw std::runtime_error("Cannot get the size of file " + file_name_);
     }
-    return *cursor++;
+    mapping_size = size.QuadPart;
+    if(mapping_size > 0){
+        mapping_handle = CreateFileMappingA(file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+        if(mapping_handle != NULL) mapping = (const char*)MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+        if(mapping == NULL){
+            ReleaseMapping();
+            throw std::runtime_error("File " + file_name_ + " cannot be mapped into memory");
+        }
+    }
+#else
+    file_descriptor = open(file_name_.c_str(), O_RDONLY);
+    if(file_descriptor == -1) throw std::runtime_error("File " + file_name_ + " not found");
+    struct stat file_stat;
+    if(fstat(file_descriptor, &file_stat) == -1){
+        ReleaseMapping();
+        throw std::runtime_error("Cannot get the size of file " + file_name_);
+    }
+    mapping_size = file_stat.st_size;
+    if(mapping_size > 0){
+        void* region = mmap(NULL, mapping_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+        if(region == MAP_FAILED){
+            ReleaseMapping();
+            throw std::runtime_error("File " + file_name_ + " cannot be mapped into memory");
+        }
+        madvise(region, mapping_size, MADV_SEQUENTIAL); // the file is parsed from the beginning to the end
+        mapping = (const char*)region;
+    }
+#endif
+    data = mapping;
+    file_size = mapping_size;
+
+    const unsigned char* magic = (const unsigned char*)mapping;
+    try{
+        if(mapping_size >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) DecompressGzip();
+        else if(mapping_size >= 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) DecompressZstd();
+    } catch(const std::exception& e){
+        ReleaseMapping();
+        throw std::runtime_error("File " + file_name_ + ": " + e.what());
+    }
+
+    cursor = data;
+    file_end = data + file_size;
+    Is_Open = true;
 }
 
-void FileReader::NextLine(){
-    char c;
+void FileReader::ReleaseMapping(){
+#ifdef _WIN32
+    if(mapping != NULL) UnmapViewOfFile(mapping);
+    if(mapping_handle != NULL) CloseHandle(mapping_handle);
+    if(file_handle != NULL) CloseHandle(file_handle);
+    mapping_handle = file_handle = NULL;
+#else
+    if(mapping != NULL) munmap((void*)mapping, mapping_size);
+    if(file_descriptor != -1) close(file_descriptor);
+    file_descriptor = -1;
+#endif
+    mapping = NULL;
+    mapping_size = 0;
+}
+
+void FileReader::DecompressGzip(){
+    /*
+        Inflate the whole file into memory, concatenated gzip members (e.g. from bgzip or cat a.gz b.gz) are supported
+        The size of the last member stored in the gzip trailer is used as a hint of the decompressed size
+    */
+#ifdef LITEEFG_WITH_ZLIB
+    // a gzip member has a 10-byte header and an 8-byte trailer
+    if(mapping_size < 18) throw std::runtime_error("gzip file is truncated, " + std::to_string(mapping_size) + " bytes is shorter than a gzip header and trailer");
+    const unsigned char* trailer = (const unsigned char*)mapping + mapping_size - 4;
+    size_t hint = trailer[0] | (trailer[1] << 8) | (trailer[2] << 16) | ((size_t)trailer[3] << 24);
+    decompressed.resize(std::max(hint, mapping_size * 4) + 1);
+
+    z_stream stream{};
+    if(inflateInit2(&stream, 15 + 32) != Z_OK) throw std::runtime_error("cannot initialize zlib");
+    size_t in_pos = 0, out_pos = 0;
     while(true){
-        c = Read();
-        if(c == '\n' || c == EOF) break;
+        if(out_pos == decompressed.size()) decompressed.resize(decompressed.size() * 2);
+        stream.next_in = (Bytef*)(mapping + in_pos);
+        stream.avail_in = (uInt)std::min<size_t>(mapping_size - in_pos, UINT_MAX);
+        stream.next_out = (Bytef*)(decompressed.data() + out_pos);
+        stream.avail_out = (uInt)std::min<size_t>(decompressed.size() - out_pos, UINT_MAX);
+        uInt avail_in = stream.avail_in, avail_out = stream.avail_out;
+        int ret = inflate(&stream, Z_NO_FLUSH);
+        in_pos += avail_in - stream.avail_in;
+        out_pos += avail_out - stream.avail_out;
+        if(ret == Z_STREAM_END){
+            if(in_pos == mapping_size) break;
+            inflateReset(&stream); // next gzip member
+        } else if(ret == Z_BUF_ERROR && in_pos == mapping_size && out_pos < decompressed.size()){
+            inflateEnd(&stream);
+            throw std::runtime_error("gzip file is truncated");
+        } else if(ret != Z_OK && ret != Z_BUF_ERROR){
+            std::string message = (stream.msg != NULL) ? stream.msg : "unknown error";
+            inflateEnd(&stream);
+            throw std::runtime_error("gzip decompression failed: " + message);
+        }
     }
+    inflateEnd(&stream);
+    decompressed.resize(out_pos);
+    ReleaseMapping();
+    data = decompressed.data();
+    file_size = decompressed.size();
+#else
+    throw std::runtime_error("the file is compressed by gzip, but LiteEFG is built without zlib");
+#endif
 }
 
-void FileReader::NextWord(){
+void FileReader::DecompressZstd(){
+    /*
+        If the decompressed size of every frame is known (e.g. files written by zstd -T0 or pzstd consist of several such frames),
+        the frames are decompressed in parallel directly into place. Otherwise the file is decompressed as a stream
+    */
+#ifdef LITEEFG_WITH_ZSTD
+    std::vector<size_t> frame_offset(1, 0), output_offset(1, 0);
+    bool is_size_known = true;
+    while(frame_offset.back() < mapping_size){
+        size_t frame_size = ZSTD_findFrameCompressedSize(mapping + frame_offset.back(), mapping_size - frame_offset.back());
+        if(ZSTD_isError(frame_size)) throw std::runtime_error(std::string("zstd decompression failed: ") + ZSTD_getErrorName(frame_size));
+        unsigned long long content_size = ZSTD_getFrameContentSize(mapping + frame_offset.back(), frame_size);
+        if(content_size == ZSTD_CONTENTSIZE_UNKNOWN || content_size == ZSTD_CONTENTSIZE_ERROR) is_size_known = false;
+        frame_offset.push_back(frame_offset.back() + frame_size);
+        output_offset.push_back(output_offset.back() + (is_size_known ? content_size : 0));
+    }
+
+    if(is_size_known){
+        int num_frames = frame_offset.size() - 1, num_workers = std::max(1, std::min(num_threads, num_frames));
+        decompressed.resize(output_offset.back());
+        Basic::ParallelFor(num_workers, [&](const int& thread_idx){
+            for(int i=thread_idx; i<num_frames; i+=num_workers){
+                size_t ret = ZSTD_decompress(decompressed.data() + output_offset[i], output_offset[i+1] - output_offset[i],
+                                             mapping + frame_offset[i], frame_offset[i+1] - frame_offset[i]);
+                if(ZSTD_isError(ret)) throw std::runtime_error(std::string("zstd decompression failed: ") + ZSTD_getErrorName(ret));
+                if(ret != output_offset[i+1] - output_offset[i]) throw std::runtime_error("zstd frame is shorter than its content size");
+            }
+        });
+    } else{
+        ZSTD_DStream* stream = ZSTD_createDStream();
+        ZSTD_initDStream(stream);
+        decompressed.resize(mapping_size * 4 + 1);
+        ZSTD_inBuffer input = {mapping, mapping_size, 0};
+        ZSTD_outBuffer output = {decompressed.data(), decompressed.size(), 0};
+        // ret is 0 only when a frame is complete and flushed, otherwise the stream still holds input or buffered output
+        size_t ret = 1;
+        while(input.pos < input.size || ret != 0){
+            if(output.pos == output.size){
+                decompressed.resize(decompressed.size() * 2);
+                output.dst = decompressed.data();
+                output.size = decompressed.size();
+            }
+            size_t input_pos = input.pos, output_pos = output.pos;
+            ret = ZSTD_decompressStream(stream, &output, &input);
+            if(ZSTD_isError(ret)){
+                ZSTD_freeDStream(stream);
+                throw std::runtime_error(std::string("zstd decompression failed: ") + ZSTD_getErrorName(ret));
+            }
+            if(ret != 0 && input.pos == input.size && input.pos == input_pos && output.pos == output_pos){
+                ZSTD_freeDStream(stream);
+                throw std::runtime_error("zstd file is truncated");
+            }
+        }
+        ZSTD_freeDStream(stream);
+        decompressed.resize(output.pos);
+    }
+    ReleaseMapping();
+    data = decompressed.data();
+    file_size = decompressed.size();
+#else
+    throw std::runtime_error("the file is compressed by zstd, but LiteEFG is built without zstd");
+#endif
+}
+
+char FileCursor::Read(){
+    if(cursor == file_end) return EOF; // End of file
+    return *cursor++;
+}
+
+void FileCursor::NextLine(){
+    while(cursor != file_end && *cursor != '\n') ++cursor;
+    if(cursor != file_end) ++cursor;
+}
+
+void FileCursor::NextWord(){
     /*
         Move the cursor to start of the next word
         Example:
         "abcd abcd"   ----->   "abcd abcd"
           ^                          ^
     */
-    char c;
-    while(true){
-        c = Read();
-        if(c == ' ' || c== '\n' || c == EOF) break;
-    }
-    while(true){
-        c = Read();
-        if(c == EOF) break;
-        if(c != ' ' && c!= '\n') {--cursor; break;}
-    }
+    while(cursor != file_end && !IsSpace(*cursor)) ++cursor;
+    while(cursor != file_end && IsSpace(*cursor)) ++cursor;
 }
 
-char FileReader::GetWord(std::string& word){
+char FileCursor::GetWord(std::string_view& word){
     /*
-        Read a word from the file and save in variable word
-        return the next character after the word
+        Read a word from the file and save in variable word, which is a view of the mapped file
+        return the next character after the word, where "\r\n" is returned as '\n'
     */
-    word = "";
-    char c;
-    while(true){ // move to the start of a word
-        c = Read();
-        if(c == EOF) {word=""; return EOF;}
-        if(c != ' ' && c!= '\n') {--cursor; break;}
-    }
+    while(cursor != file_end && IsSpace(*cursor)) ++cursor; // move to the start of a word
+    if(cursor == file_end) {word = std::string_view(); return EOF;}
 
-    while(true){
-        c = Read();
-        if(c == ' ' || c== '\n' || c == EOF) break;
-        word += c;
-    }
+    const char* start = cursor;
+    while(cursor != file_end && !IsSpace(*cursor)) ++cursor;
+    word = std::string_view(start, cursor - start);
+
+    if(cursor == file_end) return EOF;
+    char c = *cursor++;
+    if(c == '\r' && cursor != file_end && *cursor == '\n') c = *cursor++;
+    return c;
+}
+
+char FileCursor::GetWord(std::string& word){
+    std::string_view view;
+    char c = GetWord(view);
+    word.assign(view.data(), view.size());
     return c;
 }
 
+void FileReader::Close(){
+    if(!Is_Open) return;
+    ReleaseMapping();
+    std::vector<char>().swap(decompressed);
+    data = cursor = file_end = NULL;
+    file_size = 0;
+    Is_Open = false;
+}
+
 FileReader::~FileReader(){
-    fclose(file);
-}
\ No newline at end of file
+    Close();
+}
@@ -3,17 +3,21 @@
 
 #include <cstdio>
 #include <cstdlib>
-#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
 
-class FileReader {
+class FileCursor {
 public:
-    static const int MAX_BUFFER_SIZE = 1000000;
-    char buffer[MAX_BUFFER_SIZE + 5];
+    /*
+        Tokenizer over the characters in [cursor, file_end)
+        Several cursors can walk through different parts of the same file concurrently
+    */
+    const char *cursor, *file_end;
 
-    char *cursor, *file_end;
-    FILE *file;
+    FileCursor(const char* begin_, const char* end_) : cursor(begin_), file_end(end_) {}
 
-    FileReader(const std::string& file_name_);
+    static bool IsSpace(const char& c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
 
     char Read();
 
@@ -22,8 +26,43 @@ public:
     void NextWord();
 
     char GetWord(std::string& word);
+    char GetWord(std::string_view& word);
+};
+
+class FileReader : public FileCursor {
+public:
+    /*
+        The whole file is memory-mapped, so words can be returned as std::string_view into the mapping without copying
+        gzip and zstd compressed files are recognized by their magic numbers and decompressed in memory instead,
+        in which case data points to the decompressed content and the mapping is released right away
+        The content is kept alive until the FileReader is closed or destroyed
+    */
+    const char *data;
+    size_t file_size;
+    bool Is_Open = false;
+
+    const char* mapping;
+    size_t mapping_size;
+    std::vector<char> decompressed;
+    int num_threads;
+
+#ifdef _WIN32
+    void *file_handle, *mapping_handle;
+#else
+    int file_descriptor;
+#endif
+
+    FileReader() : FileCursor(NULL, NULL), data(NULL), file_size(0), mapping(NULL), mapping_size(0), num_threads(1) {} // no file is opened
+    FileReader(const std::string& file_name_, const int& num_threads_=1);
+    FileReader(const FileReader&) = delete;
+    FileReader& operator=(const FileReader&) = delete;
+
+    void ReleaseMapping();
+    void DecompressGzip();
+    void DecompressZstd();
+    void Close(); // release the content, views of the file become invalid
 
     ~FileReader();
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -13,14 +13,14 @@ bool GraphNode_cmp(const GraphNode& a, const GraphNode& b) {
 GraphNodeStatus::GraphNodeStatus(){}
 
 GraphNodeStatus* GraphNodeStatus::Enter() {
-    GraphNode::graph_status = graph_status;
-    GraphNode::graph_color = color;
+    GraphBuilder::status = graph_status;
+    GraphBuilder::color = color;
     return this;
 }
 
 void GraphNodeStatus::Exit(pybind11::args) {
-    GraphNode::graph_status = GraphNode::NodeStatus::smallest_status;
-    GraphNode::graph_color = 0;
+    GraphBuilder::status = GraphNode::NodeStatus::smallest_status;
+    GraphBuilder::color = 0;
 }
 
 ForwardNodeStatus::ForwardNodeStatus(const bool& is_static, const int& color_) : GraphNodeStatus() {
@@ -33,20 +33,45 @@ BackwardNodeStatus::BackwardNodeStatus(const bool& is_static, const int& color_)
     color = color_;
 }
 
-Graph::Graph() {
-    GraphNode::num_nodes = GraphNode::NodeIdx::start;
-    GraphNode::graph_status = GraphNode::NodeStatus::smallest_status;
+Graph::Graph(const bool& activate) {
+    /*
+        activate makes ConstVector with an int size add to this graph. Graphs held by environments only receive copies and do not activate
+    */
     graph_nodes.clear();
+    builder = std::make_shared<GraphBuilder>(&graph_nodes);
 
-    for(int i=0; i<GraphNode::num_nodes; ++i)
+    for(int i=0; i<GraphNode::NodeIdx::start; ++i) {
         graph_nodes.push_back(GraphNode(i, {}, NULL, GraphNode::NodeStatus::smallest_status)); // placeholder for some predefined variables
+        graph_nodes.back().color = 0;
+        graph_nodes.back().builder = builder;
+    }
     utility = graph_nodes[GraphNode::NodeIdx::utility];
     opponent_reach_prob = graph_nodes[GraphNode::NodeIdx::opponent_reach_prob];
     reach_prob = graph_nodes[GraphNode::NodeIdx::reach_prob];
     action_set_size = graph_nodes[GraphNode::NodeIdx::action_set_size];
     subtree_size = graph_nodes[GraphNode::NodeIdx::subtree_size];
 
-    GraphNode::graph_nodes = &graph_nodes;
+    if(activate) GraphBuilder::active = builder;
+}
+
+Graph::~Graph() {
+    // copies share the builder but not the nodes it adds to
+    if(builder != NULL && builder->graph_nodes == &graph_nodes) builder->graph_nodes = NULL;
+}
+
+Graph* Graph::Enter() {
+    /*
+        Make ConstVector with an int size add to this graph until Exit, e.g. to continue building a graph after another one was constructed
+    */
+    entered_from.push_back(GraphBuilder::active);
+    GraphBuilder::active = builder;
+    return this;
+}
+
+void Graph::Exit(pybind11::args) {
+    if(entered_from.empty()) return;
+    GraphBuilder::active = entered_from.back();
+    entered_from.pop_back();
 }
 
 void Graph::Initialize() {
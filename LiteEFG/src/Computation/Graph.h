@@ -9,6 +9,7 @@
 #include <unordered_map>
 #include <functional>
 #include <map>
+#include <memory>
 
 class GraphNodeStatus {
 public:
@@ -36,10 +37,16 @@ public:
     GraphNode utility, opponent_reach_prob, reach_prob, action_set_size, subtree_size;
     std::vector<GraphNode> graph_nodes;
     //std::vector<int> position;
+    std::shared_ptr<GraphBuilder> builder; // shared by the copies of the graph, which only read the nodes
+    std::vector<std::weak_ptr<GraphBuilder>> entered_from; // active builders replaced by Enter
 
     int timestep=0, start_idx[GraphNode::NodeStatus::status_num+1];
 
-    Graph();
+    Graph(const bool& activate=true);
+    ~Graph();
+
+    Graph* Enter();
+    void Exit(pybind11::args);
 
     void Initialize();
     int UpdateColorMapping(std::map<int, int>& color_mapping);
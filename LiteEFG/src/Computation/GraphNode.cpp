@@ -8,91 +8,117 @@
 #include <cmath>
 #include <stdexcept>
 
-int GraphNode::num_nodes = 5;
-int GraphNode::graph_status = GraphNode::NodeStatus::smallest_status;
-int GraphNode::graph_color = 0;
-std::vector<GraphNode>* GraphNode::graph_nodes = NULL;
-std::vector<std::pair<double, int> > GraphNode::constants_list;
+thread_local int GraphBuilder::status = GraphNode::NodeStatus::smallest_status;
+thread_local int GraphBuilder::color = 0;
+thread_local std::weak_ptr<GraphBuilder> GraphBuilder::active;
 
-GraphNode::GraphNode() : idx(-1), order(-1), status(GraphNode::NodeStatus::smallest_status), operation(NULL), color{GraphNode::graph_color}{dependency.clear();}
+GraphBuilder::GraphBuilder(std::vector<GraphNode>* graph_nodes_) : graph_nodes(graph_nodes_) {}
+
+std::vector<GraphNode>& GraphBuilder::GetNodes(){
+    if(graph_nodes == NULL) throw std::invalid_argument("The graph of the node has been destroyed");
+    return *graph_nodes;
+}
+
+GraphNode GraphBuilder::Add(const std::vector<int>& dependency, std::shared_ptr<Operation> operation){
+    std::vector<GraphNode>& nodes = GetNodes();
+    nodes.push_back(GraphNode(nodes.size(), dependency, operation, status));
+    nodes.back().builder = shared_from_this();
+    return nodes.back();
+}
+
+GraphNode GraphBuilder::AddConstant(const double& val){
+    std::vector<GraphNode>& nodes = GetNodes();
+    constants_list.push_back({val, (int)nodes.size()});
+    nodes.push_back(GraphNode(nodes.size(), {}, std::make_shared<StaticConstVector>(StaticConstVector(1, val)), GraphNode::NodeStatus::smallest_status));
+    nodes.back().builder = shared_from_this();
+    return nodes.back();
+}
+
+GraphNode GraphBuilder::AddConstant(const Vector& val){
+    std::vector<GraphNode>& nodes = GetNodes();
+    nodes.push_back(GraphNode(nodes.size(), {}, std::make_shared<StaticConstVector>(StaticConstVector(val)), GraphNode::NodeStatus::smallest_status));
+    nodes.back().builder = shared_from_this();
+    return nodes.back();
+}
+
+GraphNode::GraphNode() : idx(-1), order(-1), status(GraphNode::NodeStatus::smallest_status), operation(NULL), color{GraphBuilder::color}, builder(NULL){dependency.clear();}
 
 GraphNode::GraphNode(const int& idx_, const std::vector<int>& dependency_, std::shared_ptr<Operation> operation_, const int& status_)
-                    : idx(idx_), order(idx_), dependency(dependency_), operation(operation_), status(status_), color{GraphNode::graph_color}{}
+                    : idx(idx_), order(idx_), dependency(dependency_), operation(operation_), status(status_), color{GraphBuilder::color}, builder(NULL){}
 
 GraphNode::GraphNode(const int& idx_, const std::initializer_list<int>& dependency_, std::shared_ptr<Operation> operation_, const int& status_)
-                    : idx(idx_), order(idx_), dependency(dependency_), operation(operation_), status(status_), color{GraphNode::graph_color}{}
+                    : idx(idx_), order(idx_), dependency(dependency_), operation(operation_), status(status_), color{GraphBuilder::color}, builder(NULL){}
 
-GraphNode::GraphNode(const double& val){
-    constants_list.push_back({val, num_nodes});
-    idx = order = num_nodes++;
-    dependency.clear();
-    operation = std::make_shared<StaticConstVector>(StaticConstVector(1, val));
-    status = GraphNode::NodeStatus::smallest_status;
-    color = GraphNode::graph_color;
+GraphBuilder* GraphNode::GetBuilder() const{
+    if(builder == NULL) throw std::invalid_argument("The node does not belong to a graph");
+    return builder.get();
 }
 
-GraphNode::GraphNode(const Vector& val) {
-    idx = order = num_nodes++;
-    dependency.clear();
-    operation = std::make_shared<StaticConstVector>(StaticConstVector(val));
-    status = GraphNode::NodeStatus::smallest_status;
-    color = GraphNode::graph_color;
+static GraphBuilder* GetCommonBuilder(const GraphNode& lhs, const GraphNode& rhs){
+    GraphBuilder* builder = lhs.GetBuilder();
+    if(rhs.GetBuilder() != builder) throw std::invalid_argument("Nodes of different graphs cannot be used in one operation");
+    return builder;
 }
 
 GraphNode GraphNode::AddConstScalar(const double& val){
-    for(auto& elem : constants_list){
+    GraphBuilder* graph_builder = GetBuilder();
+    for(auto& elem : graph_builder->constants_list){
         if(fabs(elem.first - val) < Constants::EPS){
-            return (*graph_nodes)[elem.second];
+            return graph_builder->GetNodes()[elem.second];
         }
     }
-    return GraphNode(val);
+    return graph_builder->AddConstant(val);
 }
 
 void GraphNode::Inplace(const GraphNode& node){
-    if((*graph_nodes)[node.order].order != node.order){
+    std::vector<GraphNode>& graph_nodes = GetCommonBuilder(*this, node)->GetNodes();
+    if(graph_nodes[node.order].order != node.order){
         throw std::invalid_argument("Unexpected error");
     }
-    (*graph_nodes)[node.order].idx = idx; // change the address to store
+    graph_nodes[node.order].idx = idx; // change the address to store
 }
 
 template <typename T> GraphNode GraphNode::SingleVariableOperation(const GraphNode& node, const T& operation) {
-    GraphNode::graph_nodes->push_back(GraphNode(GraphNode::num_nodes++, {node.idx}, std::make_shared<T>(operation), GraphNode::graph_status));
-    return GraphNode::graph_nodes->back();
+    return node.GetBuilder()->Add({node.idx}, std::make_shared<T>(operation));
 }
 
 template <typename T> GraphNode GraphNode::TwoVariableOperation(const Object& rhs, const T& operation) const {
+    GraphBuilder* graph_builder = GetBuilder();
     if(std::holds_alternative<double>(rhs)){
-        graph_nodes->push_back(GraphNode(std::get<double>(rhs)));
-        graph_nodes->push_back(GraphNode(num_nodes++, {idx, graph_nodes->back().idx}, std::make_shared<T>(operation), graph_status));
+        int rhs_idx = graph_builder->AddConstant(std::get<double>(rhs)).idx;
+        return graph_builder->Add({idx, rhs_idx}, std::make_shared<T>(operation));
     } else if(std::holds_alternative<int>(rhs)){
-        graph_nodes->push_back(GraphNode(std::get<int>(rhs)));
-        graph_nodes->push_back(GraphNode(num_nodes++, {idx, graph_nodes->back().idx}, std::make_shared<T>(operation), graph_status));
+        int rhs_idx = graph_builder->AddConstant((double)std::get<int>(rhs)).idx;
+        return graph_builder->Add({idx, rhs_idx}, std::make_shared<T>(operation));
     } else {
-        graph_nodes->push_back(GraphNode(num_nodes++, {idx, std::get<GraphNode>(rhs).idx}, std::make_shared<T>(operation), graph_status));
+        graph_builder = GetCommonBuilder(*this, std::get<GraphNode>(rhs));
+        return graph_builder->Add({idx, std::get<GraphNode>(rhs).idx}, std::make_shared<T>(operation));
     }
-    return graph_nodes->back();
 }
 
 template <typename T> GraphNode GraphNode::TwoVariableOperation(const ObjectDoubleInt& lhs, const GraphNode& rhs, const T& operation) {
+    GraphBuilder* graph_builder = rhs.GetBuilder();
+    int lhs_idx;
     if(std::holds_alternative<double>(lhs)){
-        GraphNode::graph_nodes->push_back(GraphNode(std::get<double>(lhs)));
-        GraphNode::graph_nodes->push_back(GraphNode(GraphNode::num_nodes++, {GraphNode::graph_nodes->back().idx, rhs.idx}, std::make_shared<T>(operation), GraphNode::graph_status));
+        lhs_idx = graph_builder->AddConstant(std::get<double>(lhs)).idx;
     } else{
-        GraphNode::graph_nodes->push_back(GraphNode(std::get<int>(lhs)));
-        GraphNode::graph_nodes->push_back(GraphNode(GraphNode::num_nodes++, {GraphNode::graph_nodes->back().idx, rhs.idx}, std::make_shared<T>(operation), GraphNode::graph_status));
+        lhs_idx = graph_builder->AddConstant((double)std::get<int>(lhs)).idx;
     }
-    return GraphNode::graph_nodes->back();
+    return graph_builder->Add({lhs_idx, rhs.idx}, std::make_shared<T>(operation));
 }
 
 GraphNode GraphNode::ConstVector(const Object& size, const Object& val){
-    if(std::holds_alternative<int>(size) && std::holds_alternative<double>(val)){
-        GraphNode::graph_nodes->push_back(GraphNode(Vector(std::get<int>(size), std::get<double>(val))));
-        return GraphNode::graph_nodes->back();
-    } else if(std::holds_alternative<int>(size) && std::holds_alternative<int>(val)){
-        GraphNode::graph_nodes->push_back(GraphNode(Vector(std::get<int>(size), std::get<int>(val))));
-        return GraphNode::graph_nodes->back();
+    /*
+        Without node inputs, the vector is added to GraphBuilder::active, i.e. the graph constructed last or entered last by the calling thread
+    */
+    if(std::holds_alternative<int>(size) && !std::holds_alternative<GraphNode>(val)){
+        std::shared_ptr<GraphBuilder> graph_builder = GraphBuilder::active.lock();
+        if(graph_builder == NULL) throw std::invalid_argument("ConstVector needs a graph under construction");
+        if(std::holds_alternative<double>(val))
+            return graph_builder->AddConstant(Vector(std::get<int>(size), std::get<double>(val)));
+        return graph_builder->AddConstant(Vector(std::get<int>(size), std::get<int>(val)));
     } else if(std::holds_alternative<int>(size) && std::holds_alternative<GraphNode>(val)){
-        return TwoVariableOperation<StaticConstVector>(std::get<int>(size), std::holds_alternative<GraphNode>(val));
+        return TwoVariableOperation<StaticConstVector>(std::get<int>(size), std::get<GraphNode>(val));
     } else if(std::holds_alternative<GraphNode>(size)){
         return std::get<GraphNode>(size).TwoVariableOperation<StaticConstVector>(val);
     } else {
@@ -313,15 +339,17 @@ GraphNode GraphNode::Project(const GraphNode& node, const std::string& distance_
 }
 
 GraphNode GraphNode::Project(const std::string& distance_name, const Object& gamma, const GraphNode& mu){
+    std::vector<GraphNode>& graph_nodes = GetCommonBuilder(*this, mu)->GetNodes();
     TwoVariableOperation<ProjectionOperation>(gamma, ProjectionOperation(distance_name));
-    graph_nodes->back().dependency.push_back(mu.idx);
-    return graph_nodes->back();
+    graph_nodes.back().dependency.push_back(mu.idx);
+    return graph_nodes.back();
 }
 
 GraphNode GraphNode::Project(const GraphNode& node, const std::string& distance_name, const Object& gamma, const GraphNode& mu){
+    std::vector<GraphNode>& graph_nodes = GetCommonBuilder(node, mu)->GetNodes();
     node.TwoVariableOperation<ProjectionOperation>(gamma, ProjectionOperation(distance_name));
-    graph_nodes->back().dependency.push_back(mu.idx);
-    return graph_nodes->back();
+    graph_nodes.back().dependency.push_back(mu.idx);
+    return graph_nodes.back();
 }
 
 GraphNode GraphNode::Pow(const GraphNode& lhs, const Object& rhs){
@@ -333,25 +361,23 @@ GraphNode GraphNode::Pow(const ObjectDoubleInt& lhs, const GraphNode& rhs){
 }
 
 GraphNode GraphNode::Concat(const std::vector<GraphNode>& nodes){
+    if(nodes.empty()) throw std::invalid_argument("Concat needs at least one node");
     std::vector<int> dependency;
     for(const auto& node : nodes){
+        GetCommonBuilder(nodes[0], node);
         dependency.push_back(node.idx);
     }
-    graph_nodes->push_back(GraphNode(num_nodes++, dependency, std::make_shared<ConcatOperation>(ConcatOperation()), graph_status));
-    return graph_nodes->back();
+    return nodes[0].GetBuilder()->Add(dependency, std::make_shared<ConcatOperation>(ConcatOperation()));
 }
 
 GraphNode GraphNode::RandomUniform(const GraphNode& node, const double& lower, const double& upper){
-    graph_nodes->push_back(GraphNode(num_nodes++, {node.idx}, std::make_shared<RandomUniformOperation>(RandomUniformOperation(lower, upper)), graph_status));
-    return graph_nodes->back();
+    return SingleVariableOperation<RandomUniformOperation>(node, RandomUniformOperation(lower, upper));
 }
 
 GraphNode GraphNode::RandomNormal(const GraphNode& node, const double& mean, const double& stddev){
-    graph_nodes->push_back(GraphNode(num_nodes++, {node.idx}, std::make_shared<RandomNormalOperation>(RandomNormalOperation(mean, stddev)), graph_status));
-    return graph_nodes->back();
+    return SingleVariableOperation<RandomNormalOperation>(node, RandomNormalOperation(mean, stddev));
 }
 
 GraphNode GraphNode::RandomExponential(const GraphNode& node, const double& lambda){
-    graph_nodes->push_back(GraphNode(num_nodes++, {node.idx}, std::make_shared<RandomExponentialOperation>(RandomExponentialOperation(lambda)), graph_status));
-    return graph_nodes->back();
+    return SingleVariableOperation<RandomExponentialOperation>(node, RandomExponentialOperation(lambda));
 }
\ No newline at end of file
@@ -5,12 +5,15 @@
 #include "Data/Vector.h"
 #include "Computation/Projection.h"
 
+#include <memory>
 #include <string>
 #include <vector>
 #include <variant>
 
 using ObjectDoubleInt = std::variant<double, int>;
 
+class GraphBuilder;
+
 class GraphNode {
 public:
     enum NodeIdx{
@@ -32,21 +35,17 @@ public:
 
     using Object = std::variant<int, double, GraphNode>;
 
-    static int num_nodes;
-    static int graph_status, graph_color;
-    static std::vector<GraphNode>* graph_nodes;
-    static std::vector<std::pair<double, int> > constants_list;
-
     int idx, order; // idx: address of node, order: the order of node to be executed
     int status, color; //status and color of a node
     std::vector<int> dependency; // idx of the nodes that this node depends on
     std::shared_ptr<Operation> operation; // operation.Execute(dependency) --> *this
+    std::shared_ptr<GraphBuilder> builder; // builder of the graph that the node belongs to, NULL for a default-constructed node
     
     GraphNode();
     GraphNode(const int& idx_, const std::vector<int>& dependency_, std::shared_ptr<Operation> operation_, const int& status_);
     GraphNode(const int& idx_, const std::initializer_list<int>& dependency_, std::shared_ptr<Operation> operation_, const int& status_);
-    GraphNode(const double& val);
-    GraphNode(const Vector& val);
+
+    GraphBuilder* GetBuilder() const;
 
     GraphNode AddConstScalar(const double& val);
 
@@ -138,4 +137,28 @@ public:
     static GraphNode RandomExponential(const GraphNode& node, const double& lambda=1.0);
 };
 
+class GraphBuilder : public std::enable_shared_from_this<GraphBuilder> {
+public:
+    /*
+        Construction state of one Graph: its nodes and the scalar constants added so far
+        Each node keeps a pointer to the builder of its graph, and new nodes are added to the builder of their inputs,
+        so graphs can be built in any interleaving and in different threads. The graph must not move while nodes are added,
+        and graph_nodes is set to NULL when the graph is destroyed
+        Nodes share the ownership of the builder, so a node that outlives its graph still reaches it, and adding to the destroyed graph throws
+        status and color of new nodes are those of the innermost forward / backward block of the calling thread
+    */
+    std::vector<GraphNode>* graph_nodes;
+    std::vector<std::pair<double, int> > constants_list;
+
+    static thread_local int status, color;
+    static thread_local std::weak_ptr<GraphBuilder> active; // used when no input is a node, i.e. ConstVector with an int size
+
+    GraphBuilder(std::vector<GraphNode>* graph_nodes_);
+
+    std::vector<GraphNode>& GetNodes();
+    GraphNode Add(const std::vector<int>& dependency, std::shared_ptr<Operation> operation);
+    GraphNode AddConstant(const double& val);
+    GraphNode AddConstant(const Vector& val);
+};
+
 #endif
\ No newline at end of file
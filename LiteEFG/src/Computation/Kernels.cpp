@@ -0,0 +1,459 @@
+#include "Computation/Kernels.h"
+
+#include "Basic/Constants.h"
+#include "Basic/BasicFunction.h"
+#include "Computation/Projection.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+
+void KernelOperation::Gradient(Vector& gradient, const Vector& aggregate, const Vector& utility) {
+    gradient = aggregate;
+    gradient.Add(utility);
+}
+
+double KernelOperation::Dot(const Vector& lhs, const Vector& rhs) {
+    if(lhs.size != rhs.size) {
+        throw std::invalid_argument("the gradient and the strategy should have the same size");
+    }
+    double sum = 0.0;
+    for(int i = 0; i < lhs.size; ++i) {
+        sum += lhs[i] * rhs[i];
+    }
+    return sum;
+}
+
+void KernelOperation::RegretMatching(Vector& strategy, const Vector& regret) {
+    // Same as normalize(regret, p_norm=1.0, ignore_negative=True)
+    strategy = regret;
+    double sum = 0.0;
+    for(int i = 0; i < strategy.size; ++i) {
+        strategy[i] = (strategy[i] < 0.0) ? 0.0 : strategy[i];
+        sum += fabs(strategy[i]);
+    }
+    if(sum < Constants::EPS) {
+        strategy.Set(1.0 / double(strategy.size));
+        return;
+    }
+    for(int i = 0; i < strategy.size; ++i) {
+        strategy[i] /= sum;
+    }
+}
+
+void KernelOperation::MirrorStep(Vector& strategy, const Vector& reference, const Vector& gradient, const double& eta_tau,
+                                 const int& regularizer, const double& gamma, const Vector& mu) {
+    /*
+        strategy = argmax_x <gradient, x> - D(x, reference) - eta_tau' * regularizer(x) over the simplex with lowerbound gamma * mu,
+        computed in the same steps as _update of the MMD and QFR baselines. strategy may be the same vector as reference
+    */
+    if(reference.size != gradient.size) {
+        throw std::invalid_argument("the gradient and the strategy should have the same size");
+    }
+    strategy.Resize(reference.size);
+    if(regularizer == Regularizer::Euclidean) {
+        for(int i = 0; i < strategy.size; ++i) {
+            strategy[i] = (reference[i] + gradient[i]) / eta_tau;
+        }
+        if(strategy.size > 0) SparseMax(strategy, gamma, mu);
+        return;
+    }
+
+    double maximum = -Constants::INF;
+    for(int i = 0; i < strategy.size; ++i) {
+        double x = reference[i];
+        if(x <= - Constants::EPS) {
+            throw std::invalid_argument("Log requires all elements to be positive");
+        }
+        x = (x < Constants::EPS) ? std::log(Constants::EPS) : std::log(x);
+        strategy[i] = (x + gradient[i]) / eta_tau;
+        maximum = std::max(maximum, strategy[i]);
+    }
+    for(int i = 0; i < strategy.size; ++i) {
+        strategy[i] = std::exp(strategy[i] - maximum);
+    }
+    if(strategy.size > 0) EntropyMax(strategy, gamma, mu);
+}
+
+void CFRKernel::Execute(Vector& result, const std::vector<Vector*>& inputs) {
+    static thread_local Vector gradient, prediction;
+    if (inputs.size() != 4) {
+        throw std::invalid_argument("CFRKernel requires four inputs");
+    }
+
+    Vector& strategy = *inputs[2];
+    Vector& regret = *inputs[3];
+    Gradient(gradient, *inputs[0], *inputs[1]);
+    double ev = Dot(gradient, strategy);
+    if(regret.size != gradient.size) {
+        throw std::invalid_argument("the gradient and the regret should have the same size");
+    }
+
+    for(int i = 0; i < regret.size; ++i) {
+        regret[i] = (regret[i] + gradient[i]) - ev;
+        if(type != Type::vanilla) regret[i] = std::max(regret[i], 0.0);
+    }
+    if(type == Type::predictive) { // regret matching on the regret plus the last instantaneous regret as the prediction
+        prediction.Resize(regret.size);
+        for(int i = 0; i < regret.size; ++i) {
+            prediction[i] = (regret[i] + gradient[i]) - ev;
+        }
+        RegretMatching(strategy, prediction);
+    } else {
+        RegretMatching(strategy, regret);
+    }
+
+    result.Resize(1);
+    result[0] = ev;
+}
+
+void DCFRKernel::Execute(Vector& result, const std::vector<Vector*>& inputs) {
+    static thread_local Vector gradient;
+    if (inputs.size() != 10) {
+        throw std::invalid_argument("DCFRKernel requires ten inputs");
+    }
+
+    Vector& strategy = *inputs[2];
+    Vector& regret = *inputs[3];
+    Vector& avg_seq_strategy = *inputs[4];
+    Vector& avg_strategy = *inputs[5];
+    Vector& timestep = *inputs[6];
+    Vector& pos_coeff = *inputs[7];
+    Vector& neg_coeff = *inputs[8];
+    double reach_prob = (*inputs[9])[0];
+
+    double strategy_coef = pow(timestep[0] / (timestep[0] + 1.0), gamma);
+    timestep[0] = timestep[0] + 1.0;
+
+    Gradient(gradient, *inputs[0], *inputs[1]);
+    double ev = Dot(gradient, strategy);
+    if(regret.size != gradient.size || avg_seq_strategy.size != strategy.size) {
+        throw std::invalid_argument("the gradient, the regret and the average strategy should have the same size");
+    }
+
+    for(int i = 0; i < regret.size; ++i) {
+        double neg_regret = (regret[i] < 0.0) ? 1.0 : 0.0, pos_regret = (regret[i] >= 0.0) ? 1.0 : 0.0;
+        regret[i] = (neg_regret * regret[i]) * neg_coeff[0] + (pos_regret * regret[i]) * pos_coeff[0];
+        regret[i] = (regret[i] + gradient[i]) - ev;
+        avg_seq_strategy[i] = avg_seq_strategy[i] * strategy_coef + strategy[i] * reach_prob;
+    }
+    RegretMatching(avg_strategy, avg_seq_strategy);
+    RegretMatching(strategy, regret);
+
+    if(fabs(alpha) < threshold) pos_coeff[0] = pow(timestep[0], alpha) / (pow(timestep[0], alpha) + 1.0);
+    if(fabs(beta) < threshold) neg_coeff[0] = pow(timestep[0], beta) / (pow(timestep[0], beta) + 1.0);
+
+    result.Resize(1);
+    result[0] = ev;
+}
+
+void MMDKernel::Execute(Vector& result, const std::vector<Vector*>& inputs) {
+    static thread_local Vector gradient;
+    if (inputs.size() != 7) {
+        throw std::invalid_argument("MMDKernel requires seven inputs");
+    }
+
+    Vector& strategy = *inputs[2];
+    double reach_prob = (*inputs[3])[0], opponent_reach_prob = (*inputs[4])[0], alpha = (*inputs[5])[0];
+    Gradient(gradient, *inputs[0], *inputs[1]);
+
+    double ev;
+    if(feedback == Feedback::outcome) { // importance weighted by the probability of the sampled action
+        if(gradient.size != strategy.size) {
+            throw std::invalid_argument("the gradient and the strategy should have the same size");
+        }
+        ev = 0.0;
+        for(int i = 0; i < gradient.size; ++i) {
+            ev += gradient[i];
+        }
+        for(int i = 0; i < gradient.size; ++i) {
+            gradient[i] /= (strategy[i] / eta) * alpha;
+        }
+    } else {
+        ev = Dot(gradient, strategy);
+        double m_th = (feedback == Feedback::counterfactual) ? 1.0
+                    : (feedback == Feedback::trajectory_Q) ? 1.0 / reach_prob : opponent_reach_prob;
+        double divisor = (m_th / eta) * alpha;
+        for(int i = 0; i < gradient.size; ++i) {
+            gradient[i] /= divisor;
+        }
+    }
+    MirrorStep(strategy, strategy, gradient, eta * tau + 1.0, regularizer, gamma, *inputs[6]);
+
+    result.Resize(1);
+    result[0] = ev;
+}
+
+double QFRRegularizerKernel::Regularizer(const Vector& strategy, const int& regularizer, const double& tau) {
+    double sum = 0.0;
+    if(regularizer == Regularizer::Euclidean) {
+        for(int i = 0; i < strategy.size; ++i) {
+            sum += Basic::Sqr(strategy[i]);
+        }
+        return (0.5 * sum) * tau;
+    }
+
+    sum = std::log(double(strategy.size)); // shifted entropy so that the minimum value is 0
+    for(int i = 0; i < strategy.size; ++i) {
+        if(strategy[i] < -Constants::EPS) {
+            throw std::invalid_argument("Entropy requires all elements to be non-negative");
+        }
+        sum += strategy[i] * std::log(strategy[i]);
+    }
+    return sum * tau;
+}
+
+void QFRRegularizerKernel::Execute(Vector& result, const std::vector<Vector*>& inputs) {
+    if (inputs.size() != 2) {
+        throw std::invalid_argument("QFRRegularizerKernel requires two inputs");
+    }
+
+    double regularizer_value = Regularizer(*inputs[0], regularizer, tau);
+    result.Resize(1);
+    result[0] = (feedback == Feedback::outcome) ? regularizer_value : regularizer_value * (*inputs[1])[0];
+}
+
+void QFRKernel::Execute(Vector& result, const std::vector<Vector*>& inputs) {
+    static thread_local Vector gradient;
+    if (inputs.size() != 9) {
+        throw std::invalid_argument("QFRKernel requires nine inputs");
+    }
+
+    Vector& strategy = *inputs[3];
+    Vector& bar_strategy = *inputs[4];
+    double reach_prob = (*inputs[5])[0], opponent_reach_prob = (*inputs[6])[0], alpha = (*inputs[7])[0];
+    Gradient(gradient, *inputs[0], *inputs[1]);
+    gradient.Add(*inputs[2]);
+    if(gradient.size != strategy.size) {
+        throw std::invalid_argument("the gradient and the strategy should have the same size");
+    }
+
+    double regularizer_value = QFRRegularizerKernel::Regularizer(strategy, regularizer, tau), ev, eta_tau;
+    if(feedback == Feedback::outcome) {
+        eta_tau = eta * tau + 1.0;
+        ev = 0.0;
+        for(int i = 0; i < gradient.size; ++i) {
+            ev += gradient[i];
+        }
+        ev -= regularizer_value;
+        for(int i = 0; i < gradient.size; ++i) {
+            gradient[i] = ((gradient[i] / strategy[i]) * eta) / alpha;
+        }
+    } else {
+        double m_th = (feedback == Feedback::counterfactual) ? 1.0
+                    : (feedback == Feedback::trajectory_Q) ? 1.0 / reach_prob : opponent_reach_prob;
+        eta_tau = ((eta * tau) / m_th) * opponent_reach_prob + 1.0; // 1 + eta * tau / m_th * mu_{-p}(s)
+        ev = Dot(gradient, strategy) - regularizer_value * opponent_reach_prob;
+        for(int i = 0; i < gradient.size; ++i) {
+            gradient[i] = ((gradient[i] / m_th) * eta) / alpha;
+        }
+    }
+    MirrorStep(bar_strategy, bar_strategy, gradient, eta_tau, regularizer, gamma, *inputs[8]);
+    MirrorStep(strategy, bar_strategy, gradient, eta_tau, regularizer, gamma, *inputs[8]);
+
+    result.Resize(1);
+    result[0] = ev;
+}
+
+class KernelScope {
+    /*
+        Nodes added while the scope is alive belong to graph, with the status given by Enter
+        The status and the active graph of the calling thread are restored when the scope ends
+    */
+    int status;
+    std::weak_ptr<GraphBuilder> active;
+public:
+    KernelScope(Graph& graph) : status(GraphBuilder::status), active(GraphBuilder::active) {
+        GraphBuilder::active = graph.builder;
+    }
+    void Enter(const int& status_) {
+        GraphBuilder::status = status_;
+    }
+    ~KernelScope() {
+        GraphBuilder::status = status;
+        GraphBuilder::active = active;
+    }
+};
+
+static void CheckParameters(const std::string& name, const KernelParameters& params, const std::vector<std::string>& keys) {
+    for(auto& param : params) {
+        if(std::find(keys.begin(), keys.end(), param.first) == keys.end())
+            throw std::invalid_argument("Invalid parameter " + param.first + " for the native baseline " + name);
+    }
+}
+
+static double GetNumber(const KernelParameters& params, const std::string& key, const double& val) {
+    auto it = params.find(key);
+    if(it == params.end()) return val;
+    if(!std::holds_alternative<double>(it->second)) throw std::invalid_argument("Parameter " + key + " should be a number");
+    return std::get<double>(it->second);
+}
+
+static std::string GetString(const KernelParameters& params, const std::string& key, const std::string& val) {
+    auto it = params.find(key);
+    if(it == params.end()) return val;
+    if(!std::holds_alternative<std::string>(it->second)) throw std::invalid_argument("Parameter " + key + " should be a string");
+    return std::get<std::string>(it->second);
+}
+
+static int GetFeedback(const KernelParameters& params) {
+    std::string feedback = GetString(params, "feedback", "Q");
+    if(feedback == "counterfactual") return KernelOperation::Feedback::counterfactual;
+    if(feedback == "Q") return KernelOperation::Feedback::Q;
+    if(feedback == "traj-Q") return KernelOperation::Feedback::trajectory_Q;
+    if(feedback == "Outcome") return KernelOperation::Feedback::outcome;
+    throw std::invalid_argument("Invalid feedback : " + feedback + ". Only Q, traj-Q, counterfactual and Outcome are supported");
+}
+
+static int GetRegularizer(const KernelParameters& params) {
+    std::string regularizer = GetString(params, "regularizer", "Entropy");
+    if(regularizer == "Euclidean") return KernelOperation::Regularizer::Euclidean;
+    if(regularizer == "Entropy") return KernelOperation::Regularizer::Entropy;
+    throw std::invalid_argument("Invalid regularizer : " + regularizer + ". Only Euclidean and Entropy are supported");
+}
+
+static GraphNode Alpha(const bool& weighted) {
+    // Weight of the dilated regularizer, 1 or twice (the largest number of infosets below an action + 1)
+    GraphNode alpha = GraphNode::ConstVector(1, 1.0);
+    if(weighted) {
+        alpha.Inplace(GraphNode::Aggregate(alpha, "sum"));
+        alpha.Inplace((alpha.Max() + 1.0) * 2.0);
+    }
+    return alpha;
+}
+
+static KernelNodes BuildCFR(Graph& graph, const KernelParameters& params, const int& type) {
+    CheckParameters((type == CFRKernel::Type::vanilla) ? "CFR" : (type == CFRKernel::Type::plus) ? "CFRplus" : "PCFR", params, {});
+    KernelNodes kernel;
+    KernelScope scope(graph);
+
+    scope.Enter(GraphNode::NodeStatus::static_backward_node);
+    GraphNode ev = GraphNode::ConstVector(1, 0.0);
+    GraphNode strategy = GraphNode::ConstVector(graph.action_set_size, 1.0 / graph.action_set_size);
+    GraphNode regret = GraphNode::ConstVector(graph.action_set_size, 0.0);
+
+    scope.Enter(GraphNode::NodeStatus::backward_node);
+    GraphNode aggregate = GraphNode::Aggregate(ev, "sum");
+    ev.Inplace(graph.builder->Add({aggregate.idx, graph.utility.idx, strategy.idx, regret.idx}, std::make_shared<CFRKernel>(type)));
+
+    kernel.nodes["strategy"] = strategy;
+    kernel.nodes["regret"] = regret;
+    kernel.Is_Alternating = (type != CFRKernel::Type::vanilla); // baselines/CFR.py updates both players at once
+    return kernel;
+}
+
+static KernelNodes BuildDCFR(Graph& graph, const KernelParameters& params) {
+    CheckParameters("DCFR", params, {"alpha", "beta", "gamma"});
+    double alpha = GetNumber(params, "alpha", 1.5), beta = GetNumber(params, "beta", 0.0), gamma = GetNumber(params, "gamma", 2.0);
+    double threshold = 10; // alpha or beta above the threshold is infinity, i.e. the regrets of that sign are not discounted
+    KernelNodes kernel;
+    KernelScope scope(graph);
+
+    scope.Enter(GraphNode::NodeStatus::static_backward_node);
+    GraphNode timestep = GraphNode::ConstVector(1, 0.0);
+    GraphNode ev = GraphNode::ConstVector(1, 0.0);
+    GraphNode strategy = GraphNode::ConstVector(graph.action_set_size, 1.0 / graph.action_set_size);
+    GraphNode avg_seq_strategy = GraphNode::ConstVector(graph.action_set_size, 0.0);
+    GraphNode regret = GraphNode::ConstVector(graph.action_set_size, 0.0);
+    GraphNode avg_strategy = GraphNode::Copy(strategy);
+    GraphNode pos_coeff = GraphNode::ConstVector(1, (alpha > threshold) ? 1.0 : 0.0);
+    GraphNode neg_coeff = GraphNode::ConstVector(1, (beta > threshold) ? 1.0 : 0.0);
+
+    scope.Enter(GraphNode::NodeStatus::backward_node);
+    GraphNode aggregate = GraphNode::Aggregate(ev, "sum");
+    ev.Inplace(graph.builder->Add({aggregate.idx, graph.utility.idx, strategy.idx, regret.idx, avg_seq_strategy.idx, avg_strategy.idx,
+                                   timestep.idx, pos_coeff.idx, neg_coeff.idx, graph.reach_prob.idx},
+                                  std::make_shared<DCFRKernel>(alpha, beta, gamma, threshold)));
+
+    kernel.nodes["strategy"] = strategy;
+    kernel.nodes["regret"] = regret;
+    kernel.nodes["average_strategy"] = avg_strategy;
+    kernel.Is_Alternating = true;
+    return kernel;
+}
+
+static KernelNodes BuildMMD(Graph& graph, const KernelParameters& params) {
+    CheckParameters("MMD", params, {"eta", "tau", "gamma", "regularizer", "feedback", "weighted"});
+    double eta = GetNumber(params, "eta", 0.005), tau = GetNumber(params, "tau", 0.05), gamma = GetNumber(params, "gamma", 0.0);
+    int regularizer = GetRegularizer(params), feedback = GetFeedback(params);
+    bool weighted = GetNumber(params, "weighted", 0.0) != 0.0;
+    KernelNodes kernel;
+    KernelScope scope(graph);
+
+    scope.Enter(GraphNode::NodeStatus::static_backward_node);
+    GraphNode alpha = Alpha(weighted);
+    GraphNode ev = GraphNode::ConstVector(1, 0.0);
+    GraphNode mu = GraphNode::Normalize(graph.subtree_size, 1.0, true);
+    GraphNode strategy = GraphNode::ConstVector(graph.action_set_size, 1.0 / graph.action_set_size);
+
+    scope.Enter(GraphNode::NodeStatus::backward_node);
+    GraphNode aggregate = GraphNode::Aggregate(ev, "sum");
+    ev.Inplace(graph.builder->Add({aggregate.idx, graph.utility.idx, strategy.idx, graph.reach_prob.idx, graph.opponent_reach_prob.idx,
+                                   alpha.idx, mu.idx},
+                                  std::make_shared<MMDKernel>(feedback, regularizer, eta, tau, gamma)));
+
+    kernel.nodes["strategy"] = strategy;
+    return kernel;
+}
+
+static KernelNodes BuildQFR(Graph& graph, const KernelParameters& params) {
+    CheckParameters("QFR", params, {"eta", "tau", "gamma", "regularizer", "feedback", "weighted"});
+    double eta = GetNumber(params, "eta", 0.001), tau = GetNumber(params, "tau", 0.001), gamma = GetNumber(params, "gamma", 0.001);
+    int regularizer = GetRegularizer(params), feedback = GetFeedback(params);
+    bool weighted = GetNumber(params, "weighted", 0.0) != 0.0;
+    KernelNodes kernel;
+    KernelScope scope(graph);
+
+    scope.Enter(GraphNode::NodeStatus::static_backward_node);
+    GraphNode alpha = Alpha(weighted);
+    GraphNode ev = GraphNode::ConstVector(1, 0.0);
+    GraphNode mu = GraphNode::Normalize(graph.subtree_size, 1.0, true);
+    GraphNode strategy = GraphNode::ConstVector(graph.action_set_size, 1.0 / graph.action_set_size);
+    GraphNode bar_strategy = GraphNode::Copy(strategy);
+
+    scope.Enter(GraphNode::NodeStatus::backward_node);
+    GraphNode reg = graph.builder->Add({strategy.idx, graph.reach_prob.idx}, std::make_shared<QFRRegularizerKernel>(feedback, regularizer, tau));
+    GraphNode aggregate = GraphNode::Aggregate(ev, "sum");
+    GraphNode aggregate_reg = GraphNode::Aggregate(reg, "sum", "children", "opponents");
+    ev.Inplace(graph.builder->Add({aggregate.idx, graph.utility.idx, aggregate_reg.idx, strategy.idx, bar_strategy.idx,
+                                   graph.reach_prob.idx, graph.opponent_reach_prob.idx, alpha.idx, mu.idx},
+                                  std::make_shared<QFRKernel>(feedback, regularizer, eta, tau, gamma)));
+
+    kernel.nodes["strategy"] = strategy;
+    kernel.nodes["bar_strategy"] = bar_strategy;
+    return kernel;
+}
+
+using KernelBuilder = std::function<KernelNodes(Graph&, const KernelParameters&)>;
+
+static const std::map<std::string, KernelBuilder>& Registry() {
+    static const std::map<std::string, KernelBuilder> registry = {
+        {"CFR", [](Graph& graph, const KernelParameters& params) { return BuildCFR(graph, params, CFRKernel::Type::vanilla); }},
+        {"CFRplus", [](Graph& graph, const KernelParameters& params) { return BuildCFR(graph, params, CFRKernel::Type::plus); }},
+        {"PCFR", [](Graph& graph, const KernelParameters& params) { return BuildCFR(graph, params, CFRKernel::Type::predictive); }},
+        {"DCFR", BuildDCFR},
+        {"MMD", BuildMMD},
+        {"QFR", BuildQFR},
+    };
+    return registry;
+}
+
+std::vector<std::string> Kernels::Names() {
+    std::vector<std::string> names;
+    for(auto& entry : Registry()) names.push_back(entry.first);
+    return names;
+}
+
+KernelNodes Kernels::Build(Graph& graph, const std::string& name, const KernelParameters& params) {
+    auto it = Registry().find(name);
+    if(it == Registry().end()) {
+        std::string names;
+        for(auto& entry : Registry()) names += (names.empty() ? "" : ", ") + entry.first;
+        throw std::invalid_argument("Invalid native baseline : " + name + ". Only " + names + " are supported");
+    }
+    KernelNodes kernel = it->second(graph, params);
+    kernel.name = name;
+    return kernel;
+}
@@ -0,0 +1,120 @@
+#ifndef KERNELS_H_
+#define KERNELS_H_
+
+#include "Data/Vector.h"
+#include "Computation/Operations.h"
+#include "Computation/GraphNode.h"
+#include "Computation/Graph.h"
+
+#include <map>
+#include <string>
+#include <variant>
+#include <vector>
+
+class KernelOperation : public Operation {
+public:
+    /*
+        Fused update of a baseline algorithm at one infoset, which replaces the graph expressions of the algorithm by a single node
+        The state of the algorithm is kept in the results of the const nodes given as inputs, and is updated in place
+        The result is the expected value of the infoset, which is aggregated by the parent infosets
+    */
+    enum Feedback {
+        counterfactual = 0,
+        Q = 1,
+        trajectory_Q = 2,
+        outcome = 3,
+    };
+    enum Regularizer {
+        Euclidean = 0,
+        Entropy = 1,
+    };
+
+    KernelOperation(const std::string& name_) : Operation(name_) {}
+
+protected:
+    static void Gradient(Vector& gradient, const Vector& aggregate, const Vector& utility);
+    static double Dot(const Vector& lhs, const Vector& rhs);
+    static void RegretMatching(Vector& strategy, const Vector& regret);
+    static void MirrorStep(Vector& strategy, const Vector& reference, const Vector& gradient, const double& eta_tau,
+                           const int& regularizer, const double& gamma, const Vector& mu);
+};
+
+class CFRKernel : public KernelOperation {
+public:
+    // inputs: aggregate of the expected values of the children, utility, strategy, regret
+    enum Type {
+        vanilla = 0,
+        plus = 1,
+        predictive = 2,
+    };
+    int type;
+    CFRKernel(const int& type_) : KernelOperation("CFRKernel"), type{type_} {}
+    void Execute(Vector& result, const std::vector<Vector*>& inputs) override;
+};
+
+class DCFRKernel : public KernelOperation {
+public:
+    // inputs: aggregate of the expected values of the children, utility, strategy, regret, average sequence-form strategy,
+    //         average strategy, timestep, coefficients of the positive and negative regrets, reach probability
+    double alpha, beta, gamma, threshold;
+    DCFRKernel(const double& alpha_, const double& beta_, const double& gamma_, const double& threshold_)
+        : KernelOperation("DCFRKernel"), alpha{alpha_}, beta{beta_}, gamma{gamma_}, threshold{threshold_} {}
+    void Execute(Vector& result, const std::vector<Vector*>& inputs) override;
+};
+
+class MMDKernel : public KernelOperation {
+public:
+    // inputs: aggregate of the expected values of the children, utility, strategy, reach probability, opponent reach probability, alpha, mu
+    int feedback, regularizer;
+    double eta, tau, gamma;
+    MMDKernel(const int& feedback_, const int& regularizer_, const double& eta_, const double& tau_, const double& gamma_)
+        : KernelOperation("MMDKernel"), feedback{feedback_}, regularizer{regularizer_}, eta{eta_}, tau{tau_}, gamma{gamma_} {}
+    void Execute(Vector& result, const std::vector<Vector*>& inputs) override;
+};
+
+class QFRRegularizerKernel : public KernelOperation {
+public:
+    // inputs: strategy, reach probability. The result is the regularizer, multiplied by the reach probability with full information
+    int feedback, regularizer;
+    double tau;
+    QFRRegularizerKernel(const int& feedback_, const int& regularizer_, const double& tau_)
+        : KernelOperation("QFRRegularizerKernel"), feedback{feedback_}, regularizer{regularizer_}, tau{tau_} {}
+    static double Regularizer(const Vector& strategy, const int& regularizer, const double& tau);
+    void Execute(Vector& result, const std::vector<Vector*>& inputs) override;
+};
+
+class QFRKernel : public KernelOperation {
+public:
+    // inputs: aggregate of the expected values of the children, utility, aggregate of the regularizers of the opponents, strategy,
+    //         reference strategy, reach probability, opponent reach probability, alpha, mu
+    int feedback, regularizer;
+    double eta, tau, gamma;
+    QFRKernel(const int& feedback_, const int& regularizer_, const double& eta_, const double& tau_, const double& gamma_)
+        : KernelOperation("QFRKernel"), feedback{feedback_}, regularizer{regularizer_}, eta{eta_}, tau{tau_}, gamma{gamma_} {}
+    void Execute(Vector& result, const std::vector<Vector*>& inputs) override;
+};
+
+using KernelParameter = std::variant<double, std::string>;
+using KernelParameters = std::map<std::string, KernelParameter>;
+
+class KernelNodes {
+public:
+    /*
+        Nodes added to a graph by Kernels::Build. nodes["strategy"] is the current strategy
+        Is_Alternating: the players are updated one at a time, as in the update_graph of the graph baseline of the same name
+    */
+    std::string name;
+    std::map<std::string, GraphNode> nodes;
+    bool Is_Alternating = false;
+};
+
+namespace Kernels {
+    /*
+        Registry of the native baselines, which give the same iterates as the graphs of the same name in LiteEFG/baselines
+        with the same parameters, while each infoset runs one fused node instead of interpreting the graph expressions
+    */
+    std::vector<std::string> Names();
+    KernelNodes Build(Graph& graph, const std::string& name, const KernelParameters& params={});
+};
+
+#endif
@@ -15,6 +15,7 @@ void CopyOperation::Execute(Vector& result, const std::vector<Vector*>& inputs)
 }
 
 void AddOperation::Execute(Vector& result, const std::vector<Vector*>& inputs) {
+    static thread_local Vector tmp;
     if (inputs.size() == 0) {
         throw std::invalid_argument("Sum requires at least one input");
     }
@@ -27,6 +28,7 @@ void AddOperation::Execute(Vector& result, const std::vector<Vector*>& inputs) {
 }
 
 void SubOperation::Execute(Vector& result, const std::vector<Vector*>& inputs) {
+    static thread_local Vector tmp;
     if (inputs.size() != 2) {
         throw std::invalid_argument("Sub requires only two inputs");
     }
@@ -37,6 +39,7 @@ void SubOperation::Execute(Vector& result, const std::vector<Vector*>& inputs) {
 }
 
 void MulOperation::Execute(Vector& result, const std::vector<Vector*>& inputs) {
+    static thread_local Vector tmp;
     if (inputs.size() == 0) {
         throw std::invalid_argument("Mul requires at least one inputs");
     }
@@ -49,6 +52,7 @@ void MulOperation::Execute(Vector& result, const std::vector<Vector*>& inputs) {
 }
 
 void DivOperation::Execute(Vector& result, const std::vector<Vector*>& inputs) {
+    static thread_local Vector tmp;
     if (inputs.size() != 2) {
         throw std::invalid_argument("Div requires two inputs");
     }
@@ -187,6 +191,7 @@ void ArgminOperation::Execute(Vector& result, const std::vector<Vector*>& inputs
 }
 
 void MaximumOperation::Execute(Vector& result, const std::vector<Vector*>& inputs) {
+    static thread_local Vector tmp;
     if (inputs.size() != 2) {
         throw std::invalid_argument("Maximum requires only two inputs");
     }
@@ -203,6 +208,7 @@ void MaximumOperation::Execute(Vector& result, const std::vector<Vector*>& input
 }
 
 void MinimumOperation::Execute(Vector& result, const std::vector<Vector*>& inputs) {
+    static thread_local Vector tmp;
     if (inputs.size() != 2) {
         throw std::invalid_argument("Minimum requires only two inputs");
     }
@@ -265,6 +271,7 @@ AggregateOperation::AggregateOperation(std::shared_ptr<Operation> aggregator_, c
 }
 
 void AggregateOperation::Execute(Vector& result, const std::vector<Vector*>& inputs) {
+    static thread_local Vector tmp;
     result.Resize(inputs.size()); // Since result will never be one of the inputs for aggregator operation, it is fine here
     for(int i = 0; i < inputs.size(); ++i) {
         if(inputs[i] -> size == 0){
@@ -10,7 +10,8 @@ class Operation {
 public:
     bool is_static = false;
     std::string name;
-    Vector tmp, info; // tmp is an auxiliary vector, info (optional) stores the information of the operation
+    Vector info; // info (optional) stores the information of the operation
+    // Operations are shared by the copies of a graph, which may run in different threads, so auxiliary vectors are thread_local in Execute
 
     Operation(const std::string& name_, const bool& is_static_=false) : name{name_}, is_static{is_static_} {}
     virtual void Execute(Vector& result, const std::vector<Vector*>& inputs) = 0;
@@ -85,6 +85,7 @@ void EntropyMax(Vector& strategy, const double& gamma, const Vector& lowerbound)
 }
 
 void ProjectionOperation::Execute(Vector& result, const std::vector<Vector*>& inputs) {
+    static thread_local Vector lowerbound;
     /*
         inputs[0] is the vector to be projected
         inputs[1] is a 1*1 vector, the \gamma. Default is 0
@@ -6,9 +6,11 @@
 
 #include <string>
 
+// Project strategy onto the probability simplex with lowerbound gamma * lowerbound, in L2 or KL distance
+void SparseMax(Vector& strategy, const double& gamma, const Vector& lowerbound);
+void EntropyMax(Vector& strategy, const double& gamma, const Vector& lowerbound);
+
 class ProjectionOperation : public Operation {
-private:
-    Vector lowerbound;
 public:
     std::string distance_name;
     ProjectionOperation(const std::string &distance_name_, const bool& is_static_=false);
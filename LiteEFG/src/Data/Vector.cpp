@@ -160,6 +160,14 @@ double Vector::operator[](const int& index) const {
     return elements[index];
 }
 
+double* Vector::data() {
+    return elements.data();
+}
+
+const double* Vector::data() const {
+    return elements.data();
+}
+
 double Vector::Dot(const Vector& rhs) const {
     if (size != rhs.size) {
         throw std::invalid_argument("In inner product, vectors must be of the same size");
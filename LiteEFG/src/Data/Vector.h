@@ -37,6 +37,8 @@ public:
 
     double& operator[](const int& index);
     double operator[](const int& index) const;
+    double* data();
+    const double* data() const;
 
     friend Vector operator*(const double& scalar, const Vector& rhs);
 
@@ -0,0 +1,128 @@
+#include "Environment/BatchedEnvironment/BatchedEnvironment.h"
+
+#include "Basic/BasicFunction.h"
+#include "Environment/NFG/NFG.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+BatchedEnvironment::BatchedEnvironment(const std::vector<std::shared_ptr<Environment>>& environments_, const int& num_threads_)
+                                      : environments(environments_), num_threads(Basic::GetNumThreads(num_threads_)) {
+    if(environments.empty()) throw std::invalid_argument("environments should not be empty");
+    for(auto& environment : environments) if(environment == nullptr)
+        throw std::invalid_argument("environments should not contain None");
+    SetSeed(std::default_random_engine::default_seed);
+}
+
+std::shared_ptr<BatchedEnvironment> BatchedEnvironment::FromNFG(const std::vector<Tensor>& utility_matrices, const std::string& traverse_,
+                                                                const int& num_threads_){
+    /*
+        utility_matrices[p-1][b, a_1, ..., a_n] is the utility of player p in the b-th normal-form game
+        The games are built in parallel, without one Python call per game
+    */
+    if(utility_matrices.empty()) throw std::invalid_argument("utility_matrices should not be empty");
+    int player_num = utility_matrices.size();
+    for(auto& utility_matrix : utility_matrices){
+        if(utility_matrix.dim != player_num + 1 || utility_matrix.shape.size() != player_num + 1)
+            throw std::invalid_argument("the utility tensor of each player should have a batch dimension followed by player_num dimensions");
+        if(utility_matrix.shape != utility_matrices[0].shape)
+            throw std::invalid_argument("the utility tensors of all players should have the same shape");
+    }
+    int batch_size = utility_matrices[0].shape[0];
+    if(batch_size < 1) throw std::invalid_argument("the batch should contain at least 1 game");
+    std::vector<int> shape(utility_matrices[0].shape.begin() + 1, utility_matrices[0].shape.end());
+    size_t size = utility_matrices[0].data.size() / batch_size;
+
+    int num_threads = std::min(Basic::GetNumThreads(num_threads_), batch_size);
+    std::vector<std::shared_ptr<Environment>> environments(batch_size);
+    Basic::ParallelFor(num_threads, [&](const int& thread_idx){
+        for(int b=batch_size*(long long)thread_idx/num_threads; b<batch_size*(long long)(thread_idx+1)/num_threads; ++b){
+            std::vector<Tensor> game;
+            for(auto& utility_matrix : utility_matrices)
+                game.push_back(Tensor(std::vector<double>(utility_matrix.data.begin() + b * size, utility_matrix.data.begin() + (b+1) * size), shape));
+            environments[b] = std::make_shared<NFG>(player_num, game, traverse_);
+        }
+    });
+    return std::make_shared<BatchedEnvironment>(environments, num_threads_);
+}
+
+int BatchedEnvironment::Size() const{
+    return environments.size();
+}
+
+void BatchedEnvironment::SetSeed(const unsigned int& seed){
+    // The b-th game samples with seed + b
+    std::lock_guard<std::mutex> lock(mutex);
+    random_states.resize(environments.size());
+    for(int b=0; b<environments.size(); ++b) random_states[b].Seed(seed + b);
+}
+
+void BatchedEnvironment::ForEach(const std::function<void(const int&, Environment&)>& func){
+    /*
+        Call func(b, environments[b]) for all games, with the random state of the game swapped into the random state of the thread
+    */
+    std::lock_guard<std::mutex> lock(mutex);
+    int size = environments.size(), threads = std::min(num_threads, size);
+    Basic::ParallelFor(threads, [&](const int& thread_idx){
+        for(int b=size*(long long)thread_idx/threads; b<size*(long long)(thread_idx+1)/threads; ++b){
+            random_states[b].SwapWithThread();
+            try{
+                func(b, *environments[b]);
+            } catch(...){
+                random_states[b].SwapWithThread();
+                throw;
+            }
+            random_states[b].SwapWithThread();
+        }
+    });
+}
+
+void BatchedEnvironment::SetGraph(const Graph& graph_){
+    ForEach([&](const int&, Environment& environment){
+        environment.SetGraph(graph_);
+    });
+}
+
+void BatchedEnvironment::Update(const GraphNode& strategy_node, const int& upd_player, const std::vector<int>& upd_color, const std::string& traverse_type){
+    ForEach([&](const int&, Environment& environment){
+        environment.Update(strategy_node, upd_player, upd_color, traverse_type);
+    });
+}
+
+void BatchedEnvironment::UpdateStrategy(const GraphNode& strategy_node, const bool& update_best){
+    ForEach([&](const int&, Environment& environment){
+        environment.UpdateStrategy(strategy_node, update_best);
+    });
+}
+
+std::vector<std::vector<std::pair<int, std::vector<double>>>> BatchedEnvironment::Run(const std::vector<UpdateStep>& schedule, const int& iterations,
+                                                                                      const GraphNode& strategy_node, const std::string& type_name,
+                                                                                      const int& eval_every, const bool& update_best,
+                                                                                      const int& update_strategy_every){
+    /*
+        Environment::Run on every game, trace[b] is the trace of the b-th game
+        Each game runs all its iterations at once, so the games do not wait for each other between iterations
+    */
+    std::vector<std::vector<std::pair<int, std::vector<double>>>> trace(environments.size());
+    ForEach([&](const int& b, Environment& environment){
+        trace[b] = environment.Run(schedule, iterations, strategy_node, type_name, eval_every, update_best, update_strategy_every);
+    });
+    return trace;
+}
+
+std::vector<std::vector<double>> BatchedEnvironment::Utility(const GraphNode& strategy_node, const std::string& type_name){
+    std::vector<std::vector<double>> utility(environments.size());
+    ForEach([&](const int& b, Environment& environment){
+        utility[b] = environment.Utility(strategy_node, type_name);
+    });
+    return utility;
+}
+
+std::vector<std::vector<double>> BatchedEnvironment::Exploitability(const GraphNode& strategy_node, const std::string& type_name){
+    std::vector<std::vector<double>> exploitability(environments.size());
+    ForEach([&](const int& b, Environment& environment){
+        exploitability[b] = environment.Exploitability(strategy_node, type_name);
+    });
+    return exploitability;
+}
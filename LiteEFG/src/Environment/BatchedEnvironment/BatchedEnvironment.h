@@ -0,0 +1,46 @@
+#ifndef BATCHEDENVIRONMENT_H_
+#define BATCHEDENVIRONMENT_H_
+
+#include "Data/Tensor.h"
+#include "Computation/Graph.h"
+#include "Environment/Environment.h"
+#include "Basic/BasicFunction.h"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class BatchedEnvironment{
+public:
+    /*
+        Many independent games trained in lockstep with one graph, each call runs on all games without returning to Python
+        The games are split into contiguous blocks, one per thread, so every environment is only used by one thread in a call
+        Each game has its own random number generator, so sampled traversals give the same results for any num_threads
+    */
+    std::vector<std::shared_ptr<Environment>> environments;
+    std::vector<Basic::RandomState> random_states;
+    int num_threads;
+    std::mutex mutex; // held by SetSeed and ForEach, through which the other entry points run with the GIL released
+
+    BatchedEnvironment(const std::vector<std::shared_ptr<Environment>>& environments_, const int& num_threads_=0);
+    static std::shared_ptr<BatchedEnvironment> FromNFG(const std::vector<Tensor>& utility_matrices, const std::string& traverse_="Enumerate",
+                                                       const int& num_threads_=0);
+
+    int Size() const;
+    void SetSeed(const unsigned int& seed);
+    void ForEach(const std::function<void(const int&, Environment&)>& func);
+
+    void SetGraph(const Graph& graph_);
+    void Update(const GraphNode& strategy_node, const int& upd_player=-1, const std::vector<int>& upd_color={-1}, const std::string& traverse_type="default");
+    void UpdateStrategy(const GraphNode& strategy_node, const bool& update_best=false);
+    std::vector<std::vector<std::pair<int, std::vector<double>>>> Run(const std::vector<UpdateStep>& schedule, const int& iterations, const GraphNode& strategy_node,
+                                                                      const std::string& type_name="default", const int& eval_every=0, const bool& update_best=false,
+                                                                      const int& update_strategy_every=1);
+
+    std::vector<std::vector<double>> Utility(const GraphNode& strategy_node, const std::string& type_name="default");
+    std::vector<std::vector<double>> Exploitability(const GraphNode& strategy_node, const std::string& type_name="default");
+};
+
+#endif
@@ -0,0 +1,251 @@
+#include "Environment/Checkpoint.h"
+
+#include "Basic/FileReader.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+void CheckpointHash::Add(const std::string& word){
+    Add(word.size());
+    Add(word.data(), word.size());
+}
+
+void CheckpointHash::Add(const char* data, const size_t& bytes){
+    size_t i = 0;
+    for(; i + 8 <= bytes; i += 8){
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        Add(word);
+    }
+    if(i < bytes){
+        uint64_t word = 0;
+        memcpy(&word, data + i, bytes - i);
+        Add(word);
+    }
+}
+
+void CheckpointWriter::Write(const void* data, const size_t& bytes){
+    // Items are padded to 8 bytes so that every item in the mapped file is aligned
+    size_t offset = payload.size();
+    payload.resize(offset + (bytes + 7) / 8 * 8, 0);
+    if(bytes > 0) memcpy(payload.data() + offset, data, bytes);
+}
+
+void CheckpointWriter::Put(const std::string& value){
+    Put((int64_t)value.size());
+    Write(value.data(), value.size());
+}
+
+void CheckpointWriter::Put(Vector& value){
+    Put((int64_t)value.size);
+    Write(value.data(), sizeof(double) * value.size);
+}
+
+const char* CheckpointReader::Read(const size_t& bytes){
+    size_t padded = (bytes + 7) / 8 * 8;
+    if(padded > (size_t)(end - cursor)) throw std::runtime_error("Checkpoint is truncated");
+    const char* ret = cursor;
+    cursor += padded;
+    return ret;
+}
+
+int64_t CheckpointReader::GetInt(){
+    int64_t value;
+    memcpy(&value, Read(sizeof(value)), sizeof(value));
+    return value;
+}
+
+double CheckpointReader::GetDouble(){
+    double value;
+    memcpy(&value, Read(sizeof(value)), sizeof(value));
+    return value;
+}
+
+std::string CheckpointReader::GetString(){
+    int64_t size = GetInt();
+    if(size < 0) throw std::runtime_error("Checkpoint is corrupted: negative string length");
+    return std::string(Read(size), size);
+}
+
+void CheckpointReader::Get(Vector& value, const int& size){
+    int64_t stored = GetInt();
+    if(stored < 0 || (size >= 0 && stored != size))
+        throw std::runtime_error("Checkpoint does not match the environment: vector of size " + std::to_string(stored) + ", expected " + std::to_string(size));
+    const char* data = Read(sizeof(double) * stored);
+    if(value.size != stored) value = Vector((int)stored, 0.0);
+    if(stored > 0) memcpy(value.data(), data, sizeof(double) * stored);
+}
+
+static uint64_t BlockChecksum(const char* payload, const int64_t& payload_bytes, const int64_t& block_size, const int64_t& block){
+    int64_t begin = block * block_size;
+    CheckpointHash hash;
+    hash.Add(payload + begin, std::min<int64_t>(block_size, payload_bytes - begin));
+    return hash.value;
+}
+
+static void SyncFile(const std::string& file_name){
+    // Flush the file to the disk, so that it is complete before it is renamed over the checkpoint
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(file_name.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    bool ok = (handle != INVALID_HANDLE_VALUE && FlushFileBuffers(handle));
+    if(handle != INVALID_HANDLE_VALUE) CloseHandle(handle);
+#else
+    int file_descriptor = open(file_name.c_str(), O_RDWR);
+    bool ok = (file_descriptor != -1 && fsync(file_descriptor) == 0);
+    if(file_descriptor != -1) close(file_descriptor);
+#endif
+    if(!ok) throw std::runtime_error("Failed to flush file " + file_name);
+}
+
+static void SyncDirectory(const std::string& file_name){
+    // Flush the directory entry of a renamed file, the rename is already atomic without it
+#ifndef _WIN32
+    size_t slash = file_name.find_last_of('/');
+    std::string directory = (slash == std::string::npos) ? "." : (slash == 0) ? "/" : file_name.substr(0, slash);
+    int file_descriptor = open(directory.c_str(), O_RDONLY);
+    if(file_descriptor == -1) return;
+    fsync(file_descriptor);
+    close(file_descriptor);
+#endif
+}
+
+static bool ReplaceFile(const std::string& from, const std::string& to){
+    // Atomically rename from to to, replacing to if it exists
+#ifdef _WIN32
+    return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+    return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+static bool LinkFile(const std::string& existing, const std::string& link_name){
+    // A second name of existing, which fails if existing does not exist or the file system has no hard links
+    std::remove(link_name.c_str());
+#ifdef _WIN32
+    return CreateHardLinkA(link_name.c_str(), existing.c_str(), NULL);
+#else
+    return link(existing.c_str(), link_name.c_str()) == 0;
+#endif
+}
+
+int64_t Checkpoint::Save(const std::string& file_name, const int& player_num, const uint64_t& structure_hash, const uint64_t& graph_hash,
+                         const std::vector<char>& payload){
+    /*
+        Write the payload to the spare file file_name + ".tmp", flush it to the disk and rename it over file_name,
+        so file_name always holds a complete checkpoint, even if the save is interrupted
+        The replaced checkpoint becomes the next spare file. If the spare file holds a complete checkpoint with the same
+        number of blocks, only the blocks whose checksum differs from the stored one are rewritten
+    */
+    std::string spare_name = file_name + ".tmp", previous_name = file_name + ".prev";
+    CheckpointHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, magic, 8);
+    header.version = version;
+    header.byte_order = 0x01020304;
+    header.structure_hash = structure_hash;
+    header.graph_hash = graph_hash;
+    header.player_num = player_num;
+    header.payload_bytes = payload.size();
+    header.block_size = block_size;
+    header.num_blocks = (payload.size() + block_size - 1) / block_size;
+    header.complete = 1;
+
+    std::vector<uint64_t> checksums(header.num_blocks), stored;
+    for(int64_t i=0; i<header.num_blocks; ++i) checksums[i] = BlockChecksum(payload.data(), payload.size(), block_size, i);
+
+    {
+        std::ifstream in(spare_name, std::ios::binary);
+        CheckpointHeader old;
+        if(in && in.read((char*)&old, sizeof(old)) && memcmp(old.magic, magic, 8) == 0 && old.version == version && old.byte_order == header.byte_order
+           && old.complete == 1 && old.payload_bytes == header.payload_bytes && old.block_size == block_size){
+            stored.resize(header.num_blocks);
+            if(!in.read((char*)stored.data(), sizeof(uint64_t) * stored.size())) stored.clear();
+        }
+    }
+
+    int64_t data_offset = sizeof(header) + sizeof(uint64_t) * header.num_blocks, written = 0;
+    {
+        std::fstream out;
+        if(stored.size() == header.num_blocks){
+            out.open(spare_name, std::ios::binary | std::ios::in | std::ios::out);
+        } else{
+            out.open(spare_name, std::ios::binary | std::ios::out | std::ios::trunc);
+            stored.clear();
+        }
+        if(!out) throw std::runtime_error("Cannot open file " + spare_name);
+        auto sync = [&](){ // each step is on the disk before the next one starts, so complete is only set after all blocks
+            out.flush();
+            if(!out) throw std::runtime_error("Failed to write file " + spare_name);
+            SyncFile(spare_name);
+        };
+
+        header.complete = 0;
+        out.write((const char*)&header, sizeof(header));
+        sync();
+        for(int64_t i=0; i<header.num_blocks; ++i){
+            if(!stored.empty() && stored[i] == checksums[i]) continue;
+            int64_t begin = i * block_size;
+            out.seekp(data_offset + begin);
+            out.write(payload.data() + begin, std::min<int64_t>(block_size, payload.size() - begin));
+            ++written;
+        }
+        out.seekp(sizeof(header));
+        out.write((const char*)checksums.data(), sizeof(uint64_t) * checksums.size());
+        sync();
+        header.complete = 1;
+        out.seekp(0);
+        out.write((const char*)&header, sizeof(header));
+        sync();
+    }
+
+    // file_name keeps its checkpoint until the rename, and the replaced checkpoint is moved to the spare file afterwards
+    bool keep_previous = LinkFile(file_name, previous_name);
+    if(!ReplaceFile(spare_name, file_name)) throw std::runtime_error("Cannot rename " + spare_name + " to " + file_name);
+    if(keep_previous) ReplaceFile(previous_name, spare_name);
+    SyncDirectory(file_name);
+    return written;
+}
+
+void Checkpoint::Load(const std::string& file_name, const int& player_num, const uint64_t& structure_hash, const uint64_t& graph_hash,
+                      const std::function<void(CheckpointReader&)>& func){
+    /*
+        Verify the checkpoint in file_name against the environment and the checksum of every block, then call func on its payload
+    */
+    FileReader file_reader(file_name);
+    const char *data = file_reader.data, *file_end = file_reader.data + file_reader.file_size;
+    CheckpointHeader header;
+    if(file_reader.file_size < sizeof(header) || memcmp(data, magic, 8) != 0)
+        throw std::runtime_error("File " + file_name + " is not a LiteEFG checkpoint");
+    memcpy(&header, data, sizeof(header));
+    if(header.byte_order != 0x01020304) throw std::runtime_error("Checkpoint is written by a machine with different endianness");
+    if(header.version != version)
+        throw std::runtime_error("Unsupported checkpoint version " + std::to_string(header.version) + ", expected " + std::to_string(version));
+    if(header.complete != 1) throw std::runtime_error("Checkpoint " + file_name + " is incomplete, its last save was interrupted");
+    if(header.player_num != player_num || header.structure_hash != structure_hash)
+        throw std::invalid_argument("Checkpoint is saved from a different game");
+    if(header.graph_hash != graph_hash)
+        throw std::invalid_argument("Checkpoint is saved with a different graph, please set_graph with the same graph before loading");
+    if(header.block_size <= 0 || header.payload_bytes < 0 || header.num_blocks != (header.payload_bytes + header.block_size - 1) / header.block_size
+       || (size_t)(file_end - data) < sizeof(header) + sizeof(uint64_t) * header.num_blocks + header.payload_bytes)
+        throw std::runtime_error("Checkpoint is truncated");
+
+    const char* payload = data + sizeof(header) + sizeof(uint64_t) * header.num_blocks;
+    for(int64_t i=0; i<header.num_blocks; ++i){
+        uint64_t checksum;
+        memcpy(&checksum, data + sizeof(header) + sizeof(uint64_t) * i, sizeof(checksum));
+        if(BlockChecksum(payload, header.payload_bytes, header.block_size, i) != checksum) throw std::runtime_error("Checkpoint is corrupted: checksum mismatch in block " + std::to_string(i));
+    }
+
+    CheckpointReader reader(payload, payload + header.payload_bytes);
+    func(reader);
+}
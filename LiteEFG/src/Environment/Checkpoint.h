@@ -0,0 +1,77 @@
+#ifndef CHECKPOINT_H_
+#define CHECKPOINT_H_
+
+#include "Data/Vector.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+class CheckpointHeader {
+public:
+    char magic[8];
+    uint32_t version, byte_order; // byte_order is written as 0x01020304 to detect files from machines with another endianness
+    uint64_t structure_hash, graph_hash; // the game and the graph the checkpoint was saved with
+    int64_t player_num, payload_bytes, block_size, num_blocks, complete;
+};
+
+class CheckpointHash {
+public:
+    /*
+        64-bit FNV-1a over 8-byte words, used both as the fingerprint of the game and the graph, and as the checksum of each block
+    */
+    uint64_t value = 14695981039346656037ULL;
+
+    void Add(const uint64_t& word) { value = (value ^ word) * 1099511628211ULL; }
+    void Add(const std::string& word);
+    void Add(const char* data, const size_t& bytes);
+};
+
+class CheckpointWriter {
+public:
+    /*
+        Training state serialized into one buffer of 8-byte aligned items, which is split into blocks of Checkpoint::block_size bytes
+    */
+    std::vector<char> payload;
+
+    void Write(const void* data, const size_t& bytes);
+    void Put(const int64_t& value) { Write(&value, sizeof(value)); }
+    void Put(const double& value) { Write(&value, sizeof(value)); }
+    void Put(const std::string& value);
+    void Put(Vector& value);
+};
+
+class CheckpointReader {
+public:
+    // Reads the items written by CheckpointWriter in the same order, from the memory-mapped checkpoint
+    const char *cursor, *end;
+
+    CheckpointReader(const char* begin_, const char* end_) : cursor(begin_), end(end_) {}
+
+    const char* Read(const size_t& bytes);
+    int64_t GetInt();
+    double GetDouble();
+    std::string GetString();
+    void Get(Vector& value, const int& size=-1); // size >= 0 checks the length of the stored vector
+};
+
+namespace Checkpoint {
+    /*
+        Checkpoint file: a header, the checksum of each block of the payload, then the payload. Every item is 8-byte aligned,
+        so the file can be read from its memory mapping without parsing
+        Save writes to the spare file file_name + ".tmp" and renames it over file_name once it is on the disk, so a save interrupted
+        by preemption leaves the previous checkpoint in place. The spare file holds the checkpoint before the last one, and only
+        the blocks whose checksum changed since then are rewritten. complete is cleared while the blocks of the spare file are rewritten
+    */
+    static constexpr char magic[9] = "LiteEFGk";
+    static const unsigned int version = 1;
+    static const int64_t block_size = 1 << 16;
+
+    int64_t Save(const std::string& file_name, const int& player_num, const uint64_t& structure_hash, const uint64_t& graph_hash,
+                 const std::vector<char>& payload); // returns the number of blocks written
+    void Load(const std::string& file_name, const int& player_num, const uint64_t& structure_hash, const uint64_t& graph_hash,
+              const std::function<void(CheckpointReader&)>& func);
+};
+
+#endif
@@ -1,8 +1,14 @@
 #include "Environment/Environment.h"
 
+#include "Environment/Checkpoint.h"
+#include "Environment/StrategyFile.h"
 #include "Computation/Operations.h"
 #include "Basic/BasicFunction.h"
 
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <memory>
 #include <string>
 #include <stdexcept>
 
@@ -15,8 +21,40 @@ Environment::Environment(const int& player_num_, const std::string& traverse_)
     else throw std::invalid_argument("Only support [Enumerate, Outcome, External] for traverse");
 }
 
+UpdateStep::UpdateStep(const std::vector<GraphNode>& strategy_nodes_, const int& upd_player_, const std::vector<int>& upd_color_,
+                       const std::string& traverse_type_, const int& period_, const std::vector<int>& phases_, const int& start_, const int& stop_)
+                       : strategy_nodes(strategy_nodes_), upd_player(upd_player_), period(period_), start(start_), stop(stop_),
+                         upd_color(upd_color_), traverse_type(traverse_type_) {
+    if(period < 1) throw std::invalid_argument("period should be positive");
+    std::vector<int> sorted_phases(phases_);
+    for(auto& phase : sorted_phases)
+        if(phase < 0 || phase >= period) throw std::invalid_argument("phases should be in {0, ..., period-1}");
+    std::sort(sorted_phases.begin(), sorted_phases.end());
+    for(auto& phase : sorted_phases){ // consecutive phases are merged into one range
+        if(!phases.empty() && phases.back().second >= phase) phases.back().second = phase + 1;
+        else phases.push_back(std::make_pair(phase, phase + 1));
+    }
+}
+
+bool UpdateStep::IsActive(const int& iteration) const{
+    if(iteration < start || (stop > 0 && iteration > stop)) return false;
+    int phase = iteration % period;
+    auto it = std::upper_bound(phases.begin(), phases.end(), std::make_pair(phase, INT_MAX)); // first range starting after phase
+    return it != phases.begin() && phase < (it-1)->second;
+}
+
+bool ExploitabilityFuture::Done() const{
+    return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+std::vector<double> ExploitabilityFuture::Get() const{
+    return future.get();
+}
+
 void Environment::SetGraph(const Graph& graph_){
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     graph = graph_;
+    run_iterations = 0;
     if(!Flags_Initialized){
         Initialize();
     }
@@ -66,6 +104,17 @@ void Environment::SetGraph(const Graph& graph_){
     }
 }
 
+void Environment::SetCompensatedSummation(const bool& is_compensated){
+    /*
+        When enabled, gradients, utilities and counterfactual values used by Utility / Exploitability are accumulated
+        with compensated summation, so that small exploitability is not dominated by cancellation error
+    */
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    std::lock_guard<std::mutex> evaluation_lock(evaluation_mutex);
+    Is_Compensated_Summation = is_compensated;
+    for(auto& sequence_form : sequence_form_strategies) sequence_form.is_compensated = is_compensated;
+}
+
 double Environment::GetProb(Node* node, const int& strategy_node_idx, const int& action){
     if(node -> player == 0)
         return (node -> chance)[action];
@@ -85,6 +134,7 @@ Vector* Environment::GetProb(Node* node, const int& strategy_node_idx){
 void Environment::Initialize(){
 
     Node::Preprocessing(nodes, player_num);
+    infoset_names.resize(player_num+1);
 
     for(int i=0;i<=player_num;i++){
         infosets.push_back(std::vector<Infoset>());
@@ -97,8 +147,8 @@ void Environment::Initialize(){
         while(infosets[node -> player].size() <= node -> infoset) 
             infosets[node->player].push_back(Infoset());
 
-        while(infoset_names[node->player].size() < node -> infoset) 
-            infoset_names[node->player].push_back(std::to_string(infoset_names[node->player].size()-1));
+        if(infoset_names[node->player].size() < node -> infoset)
+            infoset_names[node->player].resize(node -> infoset); // infosets not named by the environment are named by their indices
 
         Infoset& infoset = infosets[node->player][node -> infoset];
         while(infoset.children.size() < node -> next_node.size())
@@ -112,6 +162,15 @@ void Environment::Initialize(){
         infoset.player = node -> player;
     }
 
+    Infoset::ComputeParentInfoset(nodes, infosets);
+    InitializeInfosets();
+}
+
+void Environment::InitializeInfosets(){
+    /*
+        infosets should already have their player, parent, parent_sequences, and one (empty) children list per action
+        Parents should be numbered before their children
+    */
     for(int player=1;player<=player_num;player++){
         for(int i=1;i<infosets[player].size();++i){
             infosets[player][infosets[player][i].parent.first].children[infosets[player][i].parent.second].push_back(i);
@@ -121,7 +180,7 @@ void Environment::Initialize(){
     for (int player=1; player<=player_num; player++){
         for(int i=0; i<infosets[player].size(); i++){
             Infoset& infoset = infosets[player][i];
-            infoset.results.resize(GraphNode::num_nodes, {});
+            infoset.results.resize(GraphNode::NodeIdx::start, {}); // InitializeAggregator resizes it to the graph in SetGraph
             infoset.size = 0;
             infoset.results[GraphNode::NodeIdx::action_set_size] = {Vector(1, double(infoset.children.size()))}; 
             infoset.results[GraphNode::NodeIdx::utility] = {Vector(infoset.children.size(), 0.0)};
@@ -142,12 +201,11 @@ void Environment::Initialize(){
         }
     }
 
-    Infoset::ComputeParentInfoset(nodes, infosets);
-
     // Initialize sequence form strategy_names
     while(sequence_form_strategies.size() <= player_num){
         int player = sequence_form_strategies.size();
         sequence_form_strategies.push_back(SequenceForm(&infosets[player]));
+        sequence_form_strategies.back().is_compensated = Is_Compensated_Summation;
     }
     Flags_Initialized = true;
 }
@@ -199,8 +257,34 @@ void Environment::UpdateTraverse(const int& upd_player){
         infosets[player][0].InitializeGraph(1.0);
     }
 
+    AccumulateUtility(upd_player);
+
+    for(int t=traverse_infoset.size()-1; t>=0; t--){
+        Infoset& infoset = *traverse_infoset[t];
+        AggregateInformation(infoset, true, GraphNode::NodeStatus::backward_node);
+        infoset.UpdateGraph(GraphNode::NodeStatus::backward_node, is_color_to_update);
+        AggregateInformation(infoset, false, GraphNode::NodeStatus::backward_node);
+    }
+
+    for(int t=0; t<traverse_infoset.size(); t++){
+        Infoset& infoset = *traverse_infoset[t];
+        AggregateInformation(infoset, false, GraphNode::NodeStatus::forward_node);
+    }
+
+    for(int t=0; t<traverse_infoset.size(); t++){
+        Infoset& infoset = *traverse_infoset[t];
+        AggregateInformation(infoset, true, GraphNode::NodeStatus::forward_node);
+        infoset.UpdateGraph(GraphNode::NodeStatus::forward_node, is_color_to_update);
+    }
+}
+
+void Environment::AccumulateUtility(const int& upd_player){
+    /*
+        Add the utility of the nodes in traverse_order to the utility of their parent sequences, weighted by the reach probability
+        of the others (Enumerate), and the opponent reach probability of the infosets of upd_player
+    */
     double reach_prob_cum_mul[player_num+2];
-    for(int t=traverse_order.size()-1; t>=0; t--) { 
+    for(int t=traverse_order.size()-1; t>=0; t--) {
         // Not just the upd_player's node should be visited. Because some terminal nodes belong to non-upd_players
         Node* node = traverse_order[t];
         
@@ -219,24 +303,6 @@ void Environment::UpdateTraverse(const int& upd_player){
             cum_mul *= node -> reach[p];
         }
     }
-
-    for(int t=traverse_infoset.size()-1; t>=0; t--){
-        Infoset& infoset = *traverse_infoset[t];
-        AggregateInformation(infoset, true, GraphNode::NodeStatus::backward_node);
-        infoset.UpdateGraph(GraphNode::NodeStatus::backward_node, is_color_to_update);
-        AggregateInformation(infoset, false, GraphNode::NodeStatus::backward_node);
-    }
-
-    for(int t=0; t<traverse_infoset.size(); t++){
-        Infoset& infoset = *traverse_infoset[t];
-        AggregateInformation(infoset, false, GraphNode::NodeStatus::forward_node);
-    }
-
-    for(int t=0; t<traverse_infoset.size(); t++){
-        Infoset& infoset = *traverse_infoset[t];
-        AggregateInformation(infoset, true, GraphNode::NodeStatus::forward_node);
-        infoset.UpdateGraph(GraphNode::NodeStatus::forward_node, is_color_to_update);
-    }
 }
 
 void Environment::Update(const GraphNode& strategy_node, const int& upd_player, std::vector<int> upd_color, const std::string& traverse_type){
@@ -251,6 +317,7 @@ void Environment::Update(std::vector<GraphNode> strategy_nodes, const int& upd_p
         traverse is the method to traverse the tree
         upd_player is the player to update the graph. If -1, update all players
     */
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     if(!Flags_Initialized){
         Initialize();
     }
@@ -268,10 +335,6 @@ void Environment::Update(std::vector<GraphNode> strategy_nodes, const int& upd_p
         is_color_to_update[color -> second] = true;
     }
 
-    traverse_order.clear();
-    nodes[0] -> reach.Resize(player_num+1); // players include chance player, with chance player idx = 0
-    nodes[0] -> reach.Set(1.0);
-    
     int current_traverse = traverse;
     if(traverse_type != "default"){
         if(traverse_type == "Enumerate") current_traverse = Traverse::Enumerate;
@@ -279,6 +342,29 @@ void Environment::Update(std::vector<GraphNode> strategy_nodes, const int& upd_p
         else if(traverse_type == "External") current_traverse = Traverse::External;
         else throw std::invalid_argument("Only support [Enumerate, Outcome, External] for traverse");
     }
+    if(current_traverse == Traverse::Enumerate || current_traverse == Traverse::Outcome){
+        GetTraverseOrder(current_traverse, strategy_nodes, upd_player);
+        UpdateTraverse(upd_player);
+    } else if (current_traverse == Traverse::External){
+        for(int player=1; player<=player_num; player++) if(CheckValidPlayer(player, upd_player)){
+            GetTraverseOrder(current_traverse, strategy_nodes, player);
+            UpdateTraverse(player);
+        }
+    } else{
+        throw std::invalid_argument("Invalid Traverse");
+    }
+}
+
+void Environment::GetTraverseOrder(const int& current_traverse, const std::vector<GraphNode>& strategy_nodes, const int& traverser){
+    /*
+        Fill traverse_order with the nodes visited by the traversal, parents before children, and compute their reach probabilities
+        strategy_nodes[player] is the strategy of player (strategy_nodes[0] is a placeholder for the chance player)
+        traverser is the player whose actions are all explored by external sampling
+    */
+    traverse_order.clear();
+    nodes[0] -> reach.Resize(player_num+1); // players include chance player, with chance player idx = 0
+    nodes[0] -> reach.Set(1.0);
+
     if(current_traverse == Traverse::Enumerate){
         traverse_order.resize(nodes.size());
         for (int i=0; i<nodes.size(); ++i){
@@ -288,9 +374,7 @@ void Environment::Update(std::vector<GraphNode> strategy_nodes, const int& upd_p
             node->reach[player] *= GetProb(nodes[node->parent.first], strategy_nodes[player].idx, node->parent.second);
             traverse_order[i] = node;
         }
-        UpdateTraverse(upd_player);
     } else if (current_traverse == Traverse::Outcome){
-        traverse_order.clear();
         traverse_order.push_back(nodes[0]);
         for (int i=0; i<traverse_order.size(); i++){
             if(traverse_order[i] -> next_node.size() == 0) continue;
@@ -302,35 +386,28 @@ void Environment::Update(std::vector<GraphNode> strategy_nodes, const int& upd_p
 
             traverse_order.push_back(next_node);
         }
-        UpdateTraverse(upd_player);
     } else if (current_traverse == Traverse::External){
-        for(int player=1; player<=player_num; player++) if(CheckValidPlayer(player, upd_player)){
-            traverse_order.clear();
-            traverse_order.push_back(nodes[0]); // same as above
-            for (int i=0; i<traverse_order.size(); i++){
-                if(traverse_order[i] -> next_node.size() == 0) continue;
-                if(traverse_order[i]->player == player){
-                    for(int action=0; action<traverse_order[i]->next_node.size(); ++action){
-                        Node* next_node = nodes[traverse_order[i]->next_node[action]];
-                        next_node -> reach = traverse_order[i]->reach;
-                        
-                        next_node -> reach[player] *= GetProb(traverse_order[i], strategy_nodes[player].idx, action);
-                        traverse_order.push_back(next_node);
-                    }
-                } else{
-                    int player = traverse_order[i]->player;
-                    int action = Basic::Sample(GetProb(traverse_order[i], strategy_nodes[player].idx));
+        traverse_order.push_back(nodes[0]); // same as above
+        for (int i=0; i<traverse_order.size(); i++){
+            if(traverse_order[i] -> next_node.size() == 0) continue;
+            if(traverse_order[i]->player == traverser){
+                for(int action=0; action<traverse_order[i]->next_node.size(); ++action){
                     Node* next_node = nodes[traverse_order[i]->next_node[action]];
-                    next_node->reach = traverse_order[i]->reach;
-                    next_node->reach[player] *= GetProb(traverse_order[i], strategy_nodes[player].idx, action);
+                    next_node -> reach = traverse_order[i]->reach;
                     
+                    next_node -> reach[traverser] *= GetProb(traverse_order[i], strategy_nodes[traverser].idx, action);
                     traverse_order.push_back(next_node);
                 }
+            } else{
+                int player = traverse_order[i]->player;
+                int action = Basic::Sample(GetProb(traverse_order[i], strategy_nodes[player].idx));
+                Node* next_node = nodes[traverse_order[i]->next_node[action]];
+                next_node->reach = traverse_order[i]->reach;
+                next_node->reach[player] *= GetProb(traverse_order[i], strategy_nodes[player].idx, action);
+                
+                traverse_order.push_back(next_node);
             }
-            UpdateTraverse(player);
         }
-    } else{
-        throw std::invalid_argument("Invalid Traverse");
     }
 }
 
@@ -341,11 +418,13 @@ void Environment::UpdateStrategy(const GraphNode& strategy_node, const bool& upd
 }
 
 void Environment::UpdateStrategy(const std::vector<GraphNode>& strategy_nodes, const bool& update_best){
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     if(strategy_nodes.size() != player_num){
         throw std::invalid_argument("strategy_names.size() needs to match player_num");
     }
+    bool is_tracked = update_best && (best_iterate_freq > 1 || best_iterate_candidates > 0);
     double exploitability = Constants::INF;
-    if(update_best){
+    if(update_best && !is_tracked){
         auto exploitability_list = Exploitability(strategy_nodes);
         exploitability = 0.0;
         for(int i=0; i<exploitability_list.size(); i++) exploitability += exploitability_list[i];
@@ -359,46 +438,191 @@ void Environment::UpdateStrategy(const std::vector<GraphNode>& strategy_nodes, c
             sequence_form_strategies[player].IsSequenceForm(sequence_form_strategies[player].strategy); // Check validility
         }
     }
+    if(is_tracked) AddBestIterateCandidate(strategy_nodes); // before the last-iterate is overwritten
     for(int i=1;i<=player_num;i++){
         sequence_form_strategies[i].UpdateStrategy(strategy_nodes[i-1].idx, exploitability);
     }
+    if(is_tracked && ++GetBestIterateTracker(strategy_nodes).num_updates % best_iterate_freq == 0){
+        VerifyBestIterate();
+    }
 }
 
-void Environment::GetGradient(const std::vector<GraphNode>& strategy_nodes, const std::string& type_name){
+std::vector<std::pair<int, std::vector<double>>> Environment::Run(const std::vector<UpdateStep>& schedule, const int& iterations, const GraphNode& strategy_node,
+                                                                  const std::string& type_name, const int& eval_every, const bool& update_best,
+                                                                  const int& update_strategy_every){
+    return Run(schedule, iterations, std::vector<GraphNode>(player_num, strategy_node), type_name, eval_every, update_best, update_strategy_every);
+}
+
+std::vector<std::pair<int, std::vector<double>>> Environment::Run(const std::vector<UpdateStep>& schedule, const int& iterations, const std::vector<GraphNode>& strategy_nodes,
+                                                                  const std::string& type_name, const int& eval_every, const bool& update_best,
+                                                                  const int& update_strategy_every){
+    /*
+        Run iterations of the training loop without returning to Python. Iteration t = ++run_iterations (1 after SetGraph) calls
+        Update for each active step of schedule in order, then UpdateStrategy if t % update_strategy_every == 0,
+        then records (t, Exploitability(strategy_nodes, type_name)) if (t-1) % eval_every == 0
+        update_strategy_every <= 0 or eval_every <= 0 disables the corresponding call
+    */
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if(strategy_nodes.size() != player_num){
+        throw std::invalid_argument("strategy_nodes.size() needs to match player_num");
+    }
+    for(auto& step : schedule){
+        if(step.strategy_nodes.size() != 1 && step.strategy_nodes.size() != player_num)
+            throw std::invalid_argument("each step of the schedule needs one strategy node, or one strategy node per player");
+    }
+    std::vector<std::pair<int, std::vector<double>>> trace;
+    for(int i=0; i<iterations; i++){
+        int t = ++run_iterations;
+        for(auto& step : schedule){
+            if(!step.IsActive(t)) continue;
+            if(step.strategy_nodes.size() == 1) Update(step.strategy_nodes[0], step.upd_player, step.upd_color, step.traverse_type);
+            else Update(step.strategy_nodes, step.upd_player, step.upd_color, step.traverse_type);
+        }
+        if(update_strategy_every > 0 && t % update_strategy_every == 0) UpdateStrategy(strategy_nodes, update_best);
+        if(eval_every > 0 && (t-1) % eval_every == 0) trace.push_back(std::make_pair(t, Exploitability(strategy_nodes, type_name)));
+    }
+    return trace;
+}
+
+void Environment::SetBestIterateTracking(const int& eval_freq, const int& num_candidates){
+    /*
+        By default, UpdateStrategy(update_best=true) computes the exploitability at every call
+        Otherwise, every call only keeps the strategy as a candidate if its movement (L1 distance to the last-iterate) is
+        among the num_candidates smallest since the last verification. The candidates are verified together in one batched
+        evaluation every eval_freq calls, or lazily when the best-iterate is requested
+    */
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if(eval_freq < 1) throw std::invalid_argument("eval_freq should be at least 1");
+    if(num_candidates < 0) throw std::invalid_argument("num_candidates should be non-negative");
+    VerifyBestIterate();
+    best_iterate_freq = eval_freq;
+    best_iterate_candidates = num_candidates;
+}
+
+BestIterateTracker& Environment::GetBestIterateTracker(const std::vector<GraphNode>& strategy_nodes){
+    std::vector<int> strategy_node_idx;
+    for(auto& strategy_node : strategy_nodes) strategy_node_idx.push_back(strategy_node.idx);
+    for(auto& tracker : best_iterate_trackers){
+        if(tracker.strategy_node_idx == strategy_node_idx) return tracker;
+    }
+    best_iterate_trackers.push_back(BestIterateTracker());
+    best_iterate_trackers.back().strategy_node_idx = strategy_node_idx;
+    return best_iterate_trackers.back();
+}
+
+void Environment::AddBestIterateCandidate(const std::vector<GraphNode>& strategy_nodes){
+    // sequence_form_strategies[player].strategy should already store the current strategy
+    double proxy = 0.0;
+    for(int player=1; player<=player_num; player++)
+        proxy += sequence_form_strategies[player].GetStrategyMovement(strategy_nodes[player-1].idx);
+
+    BestIterateTracker& tracker = GetBestIterateTracker(strategy_nodes);
+    int capacity = std::max(best_iterate_candidates, 1);
+    int slot = tracker.candidate_proxy.size();
+    if(slot < capacity){
+        tracker.candidate_proxy.push_back(proxy);
+    } else{ // replace the worst candidate
+        slot = std::max_element(tracker.candidate_proxy.begin(), tracker.candidate_proxy.end()) - tracker.candidate_proxy.begin();
+        if(proxy >= tracker.candidate_proxy[slot]) return;
+        tracker.candidate_proxy[slot] = proxy;
+    }
+    for(int player=1; player<=player_num; player++){
+        SequenceForm& sequence_form = sequence_form_strategies[player];
+        sequence_form.GetHistory(strategy_nodes[player-1].idx).SetCandidate(slot, sequence_form.strategy);
+    }
+}
+
+void Environment::VerifyBestIterate(){
+    for(auto& tracker : best_iterate_trackers) if(tracker.candidate_proxy.size() > 0){
+        int batch_size = tracker.candidate_proxy.size();
+        for(int player=1; player<=player_num; player++){
+            SequenceForm& sequence_form = sequence_form_strategies[player];
+            HistoryVersionStrategy& history = sequence_form.GetHistory(tracker.strategy_node_idx[player-1]);
+            sequence_form.ResizeBatch(batch_size);
+            for(int b=0; b<batch_size; ++b) sequence_form.SetBatchStrategy(b, history.candidates[b]);
+        }
+        {
+            std::lock_guard<std::mutex> evaluation_lock(evaluation_mutex);
+            ComputeBatchGradient();
+        }
+
+        std::vector<double> exploitability(batch_size, 0.0);
+        for(int player=1; player<=player_num; player++){
+            std::vector<double> player_exploitability = sequence_form_strategies[player].GetBatchExploitability();
+            for(int b=0; b<batch_size; ++b) exploitability[b] += player_exploitability[b];
+        }
+        for(int player=1; player<=player_num; player++){
+            HistoryVersionStrategy& history = sequence_form_strategies[player].GetHistory(tracker.strategy_node_idx[player-1]);
+            for(int b=0; b<batch_size; ++b) history.UpdateBest(history.candidates[b], exploitability[b]);
+        }
+        tracker.candidate_proxy.clear();
+    }
+}
+
+void Environment::PrepareSequenceFormStrategies(const std::vector<GraphNode>& strategy_nodes, const std::string& type_name){
     if(strategy_nodes.size() != player_num){
         throw std::invalid_argument("strategy_names.size() needs to match player_num");
     }
     if(!Flags_Initialized){
         Initialize();
     }
+    if(type_name == "best-iterate") VerifyBestIterate();
 
     for(int player=1; player<=player_num; player++){
         sequence_form_strategies[player].GetSequenceFormStrategy(strategy_nodes[player-1].idx, type_name);
         sequence_form_strategies[player].IsSequenceForm(sequence_form_strategies[player].strategy); // Check validility
     }
+}
 
-    double reach_prob_cum_mul[player_num+2];
-    for (auto* node : nodes){
-        node -> reach = nodes[node -> parent.first] -> reach;
+void Environment::GetGradient(const std::vector<GraphNode>& strategy_nodes, const std::string& type_name){
+    PrepareSequenceFormStrategies(strategy_nodes, type_name);
+    std::lock_guard<std::mutex> evaluation_lock(evaluation_mutex);
+    ComputeGradient(sequence_form_strategies);
+}
 
-        int parent_player = nodes[node->parent.first]->player;
-        if(parent_player == 0)
-            node->reach[parent_player] *= GetProb(nodes[node->parent.first], 0, node->parent.second);
-        else{
-            int idx = sequence_form_strategies[parent_player].GetIdx(node->parent_infoset[parent_player].first, node->parent_infoset[parent_player].second);
-            node->reach[parent_player] = sequence_form_strategies[parent_player].strategy[idx];
+void Environment::ComputeGradient(std::vector<SequenceForm>& sequence_forms){
+    /*
+        Walk the game tree once and accumulate the gradient of the sequence-form strategy of each player into sequence_forms
+    */
+    std::vector<double> reach(player_num+1), reach_prob_cum_mul(player_num+2);
+    WalkTerminals([&](const double& chance_reach, const std::vector<std::pair<int, int>>& parent_infoset, const double* utility){
+        reach[0] = chance_reach;
+        for(int p=1; p<=player_num; ++p){ // the reach probability of a player who never acts is 1
+            if(parent_infoset[p].first == 0) reach[p] = 1.0;
+            else reach[p] = sequence_forms[p].strategy[sequence_forms[p].GetIdx(parent_infoset[p].first, parent_infoset[p].second)];
         }
-        
-        if(node -> is_terminal){
-            reach_prob_cum_mul[player_num+1] = 1.0;
-            for(int p=player_num; p>=0; --p) reach_prob_cum_mul[p] = reach_prob_cum_mul[p+1] * node -> reach[p];
-            double cum_mul = node -> reach[0];
-            for(int p=1; p<=player_num; ++p){
-                int idx = sequence_form_strategies[p].GetIdx(node->parent_infoset[p].first, node->parent_infoset[p].second);
-                sequence_form_strategies[p].gradient[idx] += node -> GetUtility(p) * cum_mul * reach_prob_cum_mul[p+1];
-                cum_mul *= node -> reach[p];
-            }
+
+        reach_prob_cum_mul[player_num+1] = 1.0;
+        for(int p=player_num; p>=0; --p) reach_prob_cum_mul[p] = reach_prob_cum_mul[p+1] * reach[p];
+        double cum_mul = reach[0];
+        for(int p=1; p<=player_num; ++p){
+            SequenceForm& sequence_form = sequence_forms[p];
+            int idx = sequence_form.GetIdx(parent_infoset[p].first, parent_infoset[p].second);
+            if(Is_Compensated_Summation)
+                Basic::NeumaierAdd(sequence_form.gradient[idx], sequence_form.gradient_compensation[idx], utility[p] * cum_mul * reach_prob_cum_mul[p+1]);
+            else
+                sequence_form.gradient[idx] += utility[p] * cum_mul * reach_prob_cum_mul[p+1];
+            cum_mul *= reach[p];
+        }
+    });
+}
+
+void Environment::WalkTerminals(const std::function<void(const double&, const std::vector<std::pair<int, int>>&, const double*)>& func){
+    /*
+        Call func(chance_reach, parent_infoset, utility) for every terminal node, where chance_reach is the product of chance probabilities on the path,
+        parent_infoset[p] is the last (infoset, action) of player p on the path ((0, 0) if p never acts), and utility[p] is the utility of player p
+    */
+    std::vector<double> chance_reach(nodes.size(), 1.0);
+    double utility[player_num+1];
+    for (auto* node : nodes){
+        Node* parent = nodes[node -> parent.first];
+        if(node -> idx != 0){
+            chance_reach[node -> idx] = chance_reach[parent -> idx];
+            if(parent -> player == 0) chance_reach[node -> idx] *= parent -> chance[node -> parent.second];
         }
+        if(!node -> is_terminal) continue;
+        for(int p=1; p<=player_num; ++p) utility[p] = node -> GetUtility(p);
+        func(chance_reach[node -> idx], node -> parent_infoset, utility);
     }
 }
 
@@ -409,6 +633,7 @@ std::vector<double> Environment::Utility(const GraphNode& strategy_node, const s
 }
 
 std::vector<double> Environment::Utility(const std::vector<GraphNode>& strategy_nodes, const std::string& type_name){
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     GetGradient(strategy_nodes, type_name);
     std::vector<double> utility;
     for(int i=1;i<=player_num;i++) utility.push_back(sequence_form_strategies[i].GetUtility());
@@ -422,12 +647,288 @@ std::vector<double> Environment::Exploitability(const GraphNode& strategy_node,
 }
 
 std::vector<double> Environment::Exploitability(const std::vector<GraphNode>& strategy_nodes, const std::string& type_name){
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     GetGradient(strategy_nodes, type_name);
     std::vector<double> exploitability;
     for(int i=1;i<=player_num;i++) exploitability.push_back(sequence_form_strategies[i].GetExploitability());
     return exploitability;
 }
 
+ExploitabilityFuture Environment::ExploitabilityAsync(const GraphNode& strategy_node, const std::string& type_name){
+    std::vector<GraphNode> strategy_nodes;
+    for(int i=1;i<=player_num;i++) strategy_nodes.push_back(strategy_node);
+    return ExploitabilityAsync(strategy_nodes, type_name);
+}
+
+ExploitabilityFuture Environment::ExploitabilityAsync(const std::vector<GraphNode>& strategy_nodes, const std::string& type_name){
+    /*
+        Same as Exploitability, but only the sequence-form strategies are computed before returning. They are copied into
+        a second buffer, whose best responses are computed on a background thread while Update keeps using the primary buffers
+        The background walks take evaluation_mutex, so they run one at a time and after the gradients already in progress
+    */
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    PrepareSequenceFormStrategies(strategy_nodes, type_name);
+    auto snapshot = std::make_shared<std::vector<SequenceForm>>();
+    for(auto& sequence_form : sequence_form_strategies) snapshot -> push_back(sequence_form.Snapshot());
+
+    ExploitabilityFuture result;
+    result.future = std::async(std::launch::async, [this, snapshot](){
+        std::lock_guard<std::mutex> evaluation_lock(evaluation_mutex);
+        ComputeGradient(*snapshot);
+        std::vector<double> exploitability;
+        for(int i=1;i<=player_num;i++) exploitability.push_back((*snapshot)[i].GetExploitability());
+        return exploitability;
+    }).share();
+    return result;
+}
+
+void Environment::GetBatchGradient(const std::vector<std::vector<GraphNode>>& strategy_nodes, const std::vector<std::string>& type_names){
+    /*
+        Evaluate a batch of strategy profiles in a single walk of the game tree
+        The b-th profile is player i using strategy_nodes[b][i-1] with the version type_names[b]
+        Sequence-form strategies and gradients are stored as [sequence x batch] matrices, so the inner loops are over the batch
+    */
+    if(strategy_nodes.size() != type_names.size()){
+        throw std::invalid_argument("strategy_nodes.size() needs to match type_names.size()");
+    }
+    for(auto& profile : strategy_nodes) if(profile.size() != player_num){
+        throw std::invalid_argument("each profile in strategy_nodes needs one strategy node per player");
+    }
+    if(!Flags_Initialized){
+        Initialize();
+    }
+
+    if(std::find(type_names.begin(), type_names.end(), "best-iterate") != type_names.end()) VerifyBestIterate();
+
+    int batch_size = strategy_nodes.size();
+    for(int player=1; player<=player_num; player++){
+        SequenceForm& sequence_form = sequence_form_strategies[player];
+        sequence_form.ResizeBatch(batch_size);
+        for(int b=0; b<batch_size; ++b){
+            sequence_form.GetSequenceFormStrategy(strategy_nodes[b][player-1].idx, type_names[b]);
+            sequence_form.IsSequenceForm(sequence_form.strategy); // Check validility
+            sequence_form.SetBatchStrategy(b);
+        }
+    }
+    std::lock_guard<std::mutex> evaluation_lock(evaluation_mutex);
+    ComputeBatchGradient();
+}
+
+void Environment::ComputeBatchGradient(){
+    /*
+        Walk the game tree once and accumulate the gradient of every column of batch_strategy
+    */
+    int batch_size = sequence_form_strategies[1].batch_size;
+    std::vector<double> reach_prefix(batch_size), reach_suffix((player_num+2) * batch_size);
+    std::vector<const double*> reach_rows(player_num+1);
+    WalkTerminals([&](const double& chance_reach, const std::vector<std::pair<int, int>>& parent_infoset, const double* utility){
+        for(int p=1; p<=player_num; ++p){
+            int idx = sequence_form_strategies[p].GetIdx(parent_infoset[p].first, parent_infoset[p].second);
+            reach_rows[p] = &sequence_form_strategies[p].batch_strategy[idx * batch_size];
+        }
+        double* suffix_end = &reach_suffix[(player_num+1) * batch_size];
+        for(int b=0; b<batch_size; ++b) suffix_end[b] = 1.0;
+        for(int p=player_num; p>=1; --p){
+            double* cur = &reach_suffix[p * batch_size];
+            for(int b=0; b<batch_size; ++b) cur[b] = cur[b + batch_size] * reach_rows[p][b];
+        }
+        for(int b=0; b<batch_size; ++b) reach_prefix[b] = chance_reach;
+        for(int p=1; p<=player_num; ++p){
+            int idx = sequence_form_strategies[p].GetIdx(parent_infoset[p].first, parent_infoset[p].second);
+            double* gradient = &sequence_form_strategies[p].batch_gradient[idx * batch_size];
+            const double* suffix = &reach_suffix[(p+1) * batch_size];
+            if(Is_Compensated_Summation){
+                double* compensation = &sequence_form_strategies[p].batch_gradient_compensation[idx * batch_size];
+                for(int b=0; b<batch_size; ++b){
+                    Basic::NeumaierAdd(gradient[b], compensation[b], utility[p] * reach_prefix[b] * suffix[b]);
+                    reach_prefix[b] *= reach_rows[p][b];
+                }
+                continue;
+            }
+            for(int b=0; b<batch_size; ++b){
+                gradient[b] += utility[p] * reach_prefix[b] * suffix[b];
+                reach_prefix[b] *= reach_rows[p][b];
+            }
+        }
+    });
+}
+
+std::vector<std::vector<GraphNode>> ExpandBatch(const std::vector<GraphNode>& strategy_nodes, const int& player_num){
+    std::vector<std::vector<GraphNode>> profiles;
+    for(auto& strategy_node : strategy_nodes) profiles.push_back(std::vector<GraphNode>(player_num, strategy_node));
+    return profiles;
+}
+
+void BroadcastBatch(std::vector<std::vector<GraphNode>>& strategy_nodes, std::vector<std::string>& type_names){
+    // A single strategy profile or a single type name is shared by the whole batch
+    if(strategy_nodes.size() == 1 && type_names.size() > 1) strategy_nodes.resize(type_names.size(), strategy_nodes[0]);
+    if(type_names.size() == 1 && strategy_nodes.size() > 1) type_names.resize(strategy_nodes.size(), type_names[0]);
+}
+
+std::vector<std::vector<double>> Environment::BatchUtility(const std::vector<GraphNode>& strategy_nodes, const std::vector<std::string>& type_names){
+    return BatchUtility(ExpandBatch(strategy_nodes, player_num), type_names);
+}
+
+std::vector<std::vector<double>> Environment::BatchUtility(const std::vector<std::vector<GraphNode>>& strategy_nodes, const std::vector<std::string>& type_names){
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    std::vector<std::vector<GraphNode>> profiles = strategy_nodes;
+    std::vector<std::string> types = type_names;
+    BroadcastBatch(profiles, types);
+    GetBatchGradient(profiles, types);
+
+    std::vector<std::vector<double>> utility(profiles.size(), std::vector<double>(player_num, 0.0));
+    for(int i=1;i<=player_num;i++){
+        std::vector<double> player_utility = sequence_form_strategies[i].GetBatchUtility();
+        for(int b=0; b<profiles.size(); ++b) utility[b][i-1] = player_utility[b];
+    }
+    return utility;
+}
+
+std::vector<std::vector<double>> Environment::BatchExploitability(const std::vector<GraphNode>& strategy_nodes, const std::vector<std::string>& type_names){
+    return BatchExploitability(ExpandBatch(strategy_nodes, player_num), type_names);
+}
+
+std::vector<std::vector<double>> Environment::BatchExploitability(const std::vector<std::vector<GraphNode>>& strategy_nodes, const std::vector<std::string>& type_names){
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    std::vector<std::vector<GraphNode>> profiles = strategy_nodes;
+    std::vector<std::string> types = type_names;
+    BroadcastBatch(profiles, types);
+    GetBatchGradient(profiles, types);
+
+    std::vector<std::vector<double>> exploitability(profiles.size(), std::vector<double>(player_num, 0.0));
+    for(int i=1;i<=player_num;i++){
+        std::vector<double> player_exploitability = sequence_form_strategies[i].GetBatchExploitability();
+        for(int b=0; b<profiles.size(); ++b) exploitability[b][i-1] = player_exploitability[b];
+    }
+    return exploitability;
+}
+
+void Environment::LoadStrategy(const std::string& name, const int& player, const std::vector<double>& strategy){
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if(player < 1 || player > player_num){
+        throw std::invalid_argument("player out of range {1, ..., "+std::to_string(player_num)+"}");
+    }
+    if(!Flags_Initialized){
+        Initialize();
+    }
+    Vector input_strategy(strategy);
+    sequence_form_strategies[player].IsSequenceForm(input_strategy); // Check validility
+    sequence_form_strategies[player].frozen_strategies[name] = input_strategy;
+}
+
+void Environment::FreezeStrategy(const std::string& name, const GraphNode& strategy_node, const std::string& type_name){
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if(!Flags_Initialized){
+        Initialize();
+    }
+    if(type_name == "best-iterate") VerifyBestIterate();
+    for(int player=1; player<=player_num; player++){
+        SequenceForm& sequence_form = sequence_form_strategies[player];
+        sequence_form.GetSequenceFormStrategy(strategy_node.idx, type_name);
+        sequence_form.frozen_strategies[name] = sequence_form.strategy;
+    }
+}
+
+std::vector<std::vector<double>> Environment::CrossPlayUtility(const std::vector<std::vector<std::string>>& profiles){
+    /*
+        profiles[b][i-1] is the name of the frozen strategy used by player i in the b-th profile
+        All profiles are evaluated in one walk of the game tree
+    */
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    for(auto& profile : profiles) if(profile.size() != player_num){
+        throw std::invalid_argument("profile size needs to match player_num");
+    }
+    if(!Flags_Initialized){
+        Initialize();
+    }
+
+    int batch_size = profiles.size();
+    for(int player=1; player<=player_num; player++){
+        SequenceForm& sequence_form = sequence_form_strategies[player];
+        sequence_form.ResizeBatch(batch_size);
+        for(int b=0; b<batch_size; ++b)
+            sequence_form.SetBatchStrategy(b, sequence_form.GetFrozenStrategy(profiles[b][player-1]));
+    }
+    std::lock_guard<std::mutex> evaluation_lock(evaluation_mutex);
+    ComputeBatchGradient();
+
+    std::vector<std::vector<double>> utility(batch_size, std::vector<double>(player_num, 0.0));
+    for(int i=1;i<=player_num;i++){
+        std::vector<double> player_utility = sequence_form_strategies[i].GetBatchUtility();
+        for(int b=0; b<batch_size; ++b) utility[b][i-1] = player_utility[b];
+    }
+    return utility;
+}
+
+std::vector<std::vector<std::vector<double>>> Environment::MatchupMatrix(const std::vector<std::string>& row_names, const std::vector<std::string>& col_names){
+    /*
+        Two-player only. Return utility[r][c] = (utility of player 1, utility of player 2) when player 1 uses row_names[r] and player 2 uses col_names[c]
+        The utility is bilinear, so one walk with batch max(rows, cols) gives the gradient of player 1 against every column strategy
+        and the gradient of player 2 against every row strategy. Each matchup is then an inner product
+    */
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if(player_num != 2){
+        throw std::invalid_argument("MatchupMatrix only supports two-player games, use CrossPlayUtility instead");
+    }
+    if(row_names.size() == 0 || col_names.size() == 0){
+        throw std::invalid_argument("row_names and col_names should be non-empty");
+    }
+    if(!Flags_Initialized){
+        Initialize();
+    }
+
+    int rows = row_names.size(), cols = col_names.size();
+    int batch_size = std::max(rows, cols);
+    SequenceForm& row_form = sequence_form_strategies[1];
+    SequenceForm& col_form = sequence_form_strategies[2];
+    row_form.ResizeBatch(batch_size);
+    col_form.ResizeBatch(batch_size);
+    for(int b=0; b<batch_size; ++b){
+        row_form.SetBatchStrategy(b, row_form.GetFrozenStrategy(row_names[std::min(b, rows-1)]));
+        col_form.SetBatchStrategy(b, col_form.GetFrozenStrategy(col_names[std::min(b, cols-1)]));
+    }
+    std::lock_guard<std::mutex> evaluation_lock(evaluation_mutex);
+    ComputeBatchGradient();
+
+    std::vector<std::vector<std::vector<double>>> utility(rows, std::vector<std::vector<double>>(cols, std::vector<double>(2, 0.0)));
+    std::vector<std::vector<std::vector<double>>> compensation(Is_Compensated_Summation ? rows : 0, std::vector<std::vector<double>>(cols, std::vector<double>(2, 0.0)));
+    for(int i=0; i<row_form.strategy.size; ++i){
+        const double* x = &row_form.batch_strategy[i * batch_size];
+        const double* g = &row_form.batch_gradient[i * batch_size];
+        if(Is_Compensated_Summation){
+            // as in SequenceForm::GetBatchUtility, the compensation of the gradient is added to that of the utility
+            const double* gc = &row_form.batch_gradient_compensation[i * batch_size];
+            for(int r=0; r<rows; ++r) if(x[r] != 0.0)
+                for(int c=0; c<cols; ++c){
+                    Basic::NeumaierMulAdd(utility[r][c][0], compensation[r][c][0], x[r], g[c]);
+                    compensation[r][c][0] += x[r] * gc[c];
+                }
+            continue;
+        }
+        for(int r=0; r<rows; ++r) if(x[r] != 0.0)
+            for(int c=0; c<cols; ++c) utility[r][c][0] += x[r] * g[c];
+    }
+    for(int i=0; i<col_form.strategy.size; ++i){
+        const double* y = &col_form.batch_strategy[i * batch_size];
+        const double* g = &col_form.batch_gradient[i * batch_size];
+        if(Is_Compensated_Summation){
+            const double* gc = &col_form.batch_gradient_compensation[i * batch_size];
+            for(int c=0; c<cols; ++c) if(y[c] != 0.0)
+                for(int r=0; r<rows; ++r){
+                    Basic::NeumaierMulAdd(utility[r][c][1], compensation[r][c][1], y[c], g[r]);
+                    compensation[r][c][1] += y[c] * gc[r];
+                }
+            continue;
+        }
+        for(int c=0; c<cols; ++c) if(y[c] != 0.0)
+            for(int r=0; r<rows; ++r) utility[r][c][1] += y[c] * g[r];
+    }
+    for(int r=0; r<compensation.size(); ++r)
+        for(int c=0; c<cols; ++c)
+            for(int k=0; k<2; ++k) utility[r][c][k] += compensation[r][c][k];
+    return utility;
+}
+
 std::vector<double> Environment::GetSequenceFormStrategy(const int& player, const GraphNode& strategy_node){
     sequence_form_strategies[player].GetSequenceFormStrategy(strategy_node.idx);
     std::vector<double> ret_strategy = std::vector<double>(sequence_form_strategies[player].strategy.size, 0.0);
@@ -437,6 +938,7 @@ std::vector<double> Environment::GetSequenceFormStrategy(const int& player, cons
 }
 
 std::vector<std::pair<std::string, std::vector<double>> > Environment::GetValue(const int& player, const GraphNode& node){
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     if(player < 1 || player > player_num){
         throw std::invalid_argument("player out of range {1, ..., "+std::to_string(player_num)+"}");
     }
@@ -453,10 +955,12 @@ std::vector<std::pair<std::string, std::vector<double>> > Environment::GetValue(
 }
 
 std::vector<std::pair<std::string, std::vector<double>> > Environment::GetStrategy(const int& player, const GraphNode& strategy_node, const std::string& type_name){
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     if(player < 1 || player > player_num){
         throw std::invalid_argument("player out of range {1, ..., "+std::to_string(player_num)+"}");
     }
     std::vector<std::pair<std::string, std::vector<double>> > ret;
+    if(type_name == "best-iterate") VerifyBestIterate();
     sequence_form_strategies[player].GetSequenceFormStrategy(strategy_node.idx, type_name);
     for(int i=1, start_idx, end_idx; i<infosets[player].size(); ++i){
         Infoset& infoset = infosets[player][i];
@@ -476,7 +980,77 @@ std::vector<std::pair<std::string, std::vector<double>> > Environment::GetStrate
     return ret;
 }
 
+FlatValues Environment::GetFlatValue(const int& player, const GraphNode& node){
+    /*
+        Same values as GetValue, but stored in one array keyed by infoset index, names can be queried by GetInfosetNames
+    */
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if(player < 1 || player > player_num){
+        throw std::invalid_argument("player out of range {1, ..., "+std::to_string(player_num)+"}");
+    }
+    FlatValues ret;
+    ret.indptr.resize(infosets[player].size());
+    for(int i=1; i<infosets[player].size(); ++i)
+        ret.indptr[i] = ret.indptr[i-1] + infosets[player][i].results[node.idx][0].size;
+    ret.values.resize(ret.indptr.back());
+    for(int i=1; i<infosets[player].size(); ++i){
+        const Vector& result = infosets[player][i].results[node.idx][0];
+        std::copy(result.data(), result.data() + result.size, ret.values.data() + ret.indptr[i-1]);
+    }
+    return ret;
+}
+
+FlatValues Environment::GetFlatStrategy(const int& player, const GraphNode& strategy_node, const std::string& type_name){
+    /*
+        Same strategy as GetStrategy, but stored in one array keyed by infoset index
+    */
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if(player < 1 || player > player_num){
+        throw std::invalid_argument("player out of range {1, ..., "+std::to_string(player_num)+"}");
+    }
+    if(type_name == "best-iterate") VerifyBestIterate();
+    SequenceForm& sequence_form = sequence_form_strategies[player];
+    sequence_form.GetSequenceFormStrategy(strategy_node.idx, type_name);
+
+    FlatValues ret;
+    ret.indptr.reserve(infosets[player].size());
+    ret.values.reserve(sequence_form.strategy.size);
+    for(int i=1; i<infosets[player].size(); ++i){
+        int start_idx = sequence_form.start_sequence[i], end_idx = sequence_form.end_sequence[i];
+        double sum = 0.0;
+        for(int j=start_idx; j<end_idx; ++j) sum += sequence_form.strategy[j];
+        for(int j=start_idx; j<end_idx; ++j)
+            ret.values.push_back((sum < Constants::EPS) ? 1.0 / (end_idx - start_idx) : sequence_form.strategy[j] / sum);
+        ret.indptr.push_back(ret.values.size());
+    }
+    return ret;
+}
+
+std::vector<std::string> Environment::GetInfosetNames(const int& player, const std::vector<int>& indices){
+    /*
+        Names of infosets indices[0], indices[1], ... of player (infoset i is the row i-1 of GetFlatValue), all infosets if indices is empty
+    */
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if(player < 1 || player > player_num){
+        throw std::invalid_argument("player out of range {1, ..., "+std::to_string(player_num)+"}");
+    }
+    std::vector<std::string> ret;
+    if(indices.empty()){
+        ret.reserve(infoset_names[player].size());
+        for(int i=0; i<infoset_names[player].size(); ++i) ret.push_back(infoset_names[player][i]);
+        return ret;
+    }
+    ret.reserve(indices.size());
+    for(auto& idx : indices){
+        if(idx < 0 || idx >= infoset_names[player].size())
+            throw std::out_of_range("infoset index " + std::to_string(idx) + " out of range [0, " + std::to_string(infoset_names[player].size()) + ")");
+        ret.push_back(infoset_names[player][idx]);
+    }
+    return ret;
+}
+
 void Environment::SetValue(const int& player, const GraphNode& node, const std::vector<std::vector<double>>& values){
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     if(player < 1 || player > player_num){
         throw std::invalid_argument("player out of range {1, ..., "+std::to_string(player_num)+"}");
     }
@@ -495,25 +1069,333 @@ void Environment::SetValue(const int& player, const GraphNode& node, const std::
 }
 
 void Environment::SetValue(const int& player, const GraphNode& node, const std::vector<double>& values){
+    SetValue(player, node, values.data(), values.size());
+}
+
+void Environment::SetValue(const int& player, const GraphNode& node, const double* values, const size_t& size){
+    /*
+        values is the concatenation of the values of infosets 1, 2, ..., as returned by GetFlatValue
+    */
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     if(player < 1 || player > player_num){
         throw std::invalid_argument("player out of range {1, ..., "+std::to_string(player_num)+"}");
     }
 
-    int total_size = 0;
+    size_t total_size = 0;
     for(int i=1; i<infosets[player].size(); ++i)
         total_size += infosets[player][i].results[node.idx][0].size;
-    if(values.size() != total_size){
+    if(size != total_size){
         throw std::length_error("values size does not match number of variables in the computation graph");
     }
 
-    for(int i=1, start=0; i<infosets[player].size(); ++i){
-        Infoset& infoset = infosets[player][i];
-        for(int j=0; j<infoset.results[node.idx][0].size; ++j)
-            infoset.results[node.idx][0][j] = values[start+j];
-        start += infoset.results[node.idx][0].size;
+    for(int i=1; i<infosets[player].size(); ++i){
+        Vector& result = infosets[player][i].results[node.idx][0];
+        std::copy(values, values + result.size, result.data());
+        values += result.size;
+    }
+}
+
+SparseStrategy Environment::GetSparseStrategy(const int& player, const GraphNode& strategy_node, const std::string& type_name, const double& threshold){
+    /*
+        Same strategy as GetStrategy, but only the actions with probability larger than threshold are kept
+    */
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if(player < 1 || player > player_num){
+        throw std::invalid_argument("player out of range {1, ..., "+std::to_string(player_num)+"}");
+    }
+    if(type_name == "best-iterate") VerifyBestIterate();
+    SequenceForm& sequence_form = sequence_form_strategies[player];
+    sequence_form.GetSequenceFormStrategy(strategy_node.idx, type_name);
+
+    SparseStrategy ret;
+    ret.indptr.reserve(infosets[player].size());
+    for(int i=1; i<infosets[player].size(); ++i){
+        int start_idx = sequence_form.start_sequence[i], end_idx = sequence_form.end_sequence[i];
+        double sum = 0.0;
+        for(int j=start_idx; j<end_idx; ++j) sum += sequence_form.strategy[j];
+        for(int j=start_idx; j<end_idx; ++j){
+            double value = (sum < Constants::EPS) ? 1.0 / (end_idx - start_idx) : sequence_form.strategy[j] / sum;
+            if(value > threshold){
+                ret.indices.push_back(j - start_idx);
+                ret.values.push_back(value);
+            }
+        }
+        ret.indptr.push_back(ret.indices.size());
+    }
+    return ret;
+}
+
+void Environment::ExportStrategy(const std::string& file_name, const GraphNode& strategy_node, const std::string& type_name, const double& threshold,
+                                 const std::string& codec, const int& num_threads){
+    /*
+        Write the strategies of all players, as given by GetSparseStrategy, to a columnar strategy file (see StrategyFile)
+    */
+    int codec_idx = StrategyFile::GetCodec(codec);
+    StrategyTable table;
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex);
+        for(int player=1; player<=player_num; ++player){
+            SparseStrategy strategy = GetSparseStrategy(player, strategy_node, type_name, threshold);
+            const InfosetNames& names = infoset_names[player];
+            for(int i=1; i<strategy.indptr.size(); ++i){
+                table.player.push_back(player);
+                table.infoset.push_back(i-1);
+                table.indptr.push_back(table.indptr.back() + strategy.indptr[i] - strategy.indptr[i-1]);
+                table.names.push_back((i-1 < names.size() && names.IsNamed(i-1)) ? names.View(i-1) : std::string_view());
+            }
+            table.action.insert(table.action.end(), strategy.indices.begin(), strategy.indices.end());
+            table.probability.insert(table.probability.end(), strategy.values.begin(), strategy.values.end());
+        }
+    }
+    StrategyFile::Write(file_name, table, codec_idx, num_threads);
+}
+
+void Environment::SetSparseValue(const int& player, const GraphNode& node, const SparseStrategy& values){
+    /*
+        Set the variables at node, entries not listed in values are set to 0
+    */
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if(player < 1 || player > player_num){
+        throw std::invalid_argument("player out of range {1, ..., "+std::to_string(player_num)+"}");
+    }
+    if(values.indptr.size() != infosets[player].size()){
+        throw std::invalid_argument("indptr size does not match number of infosets + 1");
+    }
+    if(values.indices.size() != values.values.size() || values.indptr.back() != values.indices.size()){
+        throw std::invalid_argument("indices and values should both have indptr[-1] elements");
+    }
+    if(values.indptr[0] != 0){
+        throw std::invalid_argument("indptr should start from 0");
+    }
+    for(int i=1; i<values.indptr.size(); ++i){
+        if(values.indptr[i] < values.indptr[i-1]){
+            throw std::invalid_argument("indptr should be non-decreasing, but indptr[" + std::to_string(i) + "] < indptr[" + std::to_string(i-1) + "]");
+        }
+    }
+
+    // Everything is checked before writing, so invalid values leave the variables unchanged
+    for(int i=1; i<infosets[player].size(); ++i){
+        int size = infosets[player][i].results[node.idx][0].size;
+        for(int k=values.indptr[i-1]; k<values.indptr[i]; ++k){
+            if(values.indices[k] < 0 || values.indices[k] >= size){
+                throw std::length_error("index " + std::to_string(values.indices[k]) + " in infoset " + infoset_names[player][i-1] + " exceeds the size of the variable in the computation graph");
+            }
+        }
+    }
+
+    for(int i=1; i<infosets[player].size(); ++i){
+        Vector& result = infosets[player][i].results[node.idx][0];
+        result.Set(0.0);
+        for(int k=values.indptr[i-1]; k<values.indptr[i]; ++k) result[values.indices[k]] = values.values[k];
+    }
+}
+
+static uint64_t StructureHash(const std::vector<std::vector<Infoset>>& infosets, const int& player_num){
+    // Fingerprint of the infoset tree of each player, which determines the layout of the results and of the sequence-form strategies
+    CheckpointHash hash;
+    for(int player=1; player<=player_num; player++){
+        hash.Add(infosets[player].size());
+        for(auto& infoset : infosets[player]){
+            hash.Add(infoset.parent.first);
+            hash.Add(infoset.parent.second);
+            hash.Add(infoset.children.size());
+        }
+    }
+    return hash.value;
+}
+
+static uint64_t GraphHash(const Graph& graph){
+    // Fingerprint of the nodes of the graph and their dependencies, without the parameters of the operations
+    CheckpointHash hash;
+    hash.Add(graph.graph_nodes.size());
+    for(auto& graph_node : graph.graph_nodes){
+        hash.Add(graph_node.status);
+        hash.Add(graph_node.color);
+        hash.Add(graph_node.dependency.size());
+        for(auto& dependency : graph_node.dependency) hash.Add(dependency);
+        hash.Add(graph_node.operation != NULL ? graph_node.operation->name : std::string());
+    }
+    return hash.value;
+}
+
+int64_t Environment::Save(const std::string& file_name){
+    /*
+        Save the training state: the results of the graph at every infoset, the history versions of the sequence-form strategies,
+        the frozen strategies, the best-iterate trackers and the iteration count of Run. The game and the graph are not saved,
+        but their fingerprints are, so Load refuses a checkpoint of another game or graph
+        The items whose size is fixed by the game and the graph come first, so their blocks keep the same offsets across saves
+        Return the number of blocks written
+    */
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if(!Flags_Initialized){
+        Initialize();
+    }
+    CheckpointWriter writer;
+    for(int player=1; player<=player_num; player++){
+        for(auto& infoset : infosets[player]){
+            writer.Put((int64_t)infoset.results.size());
+            for(auto& result : infoset.results){
+                writer.Put((int64_t)result.size());
+                for(auto& value : result) writer.Put(value);
+            }
+        }
+    }
+    for(int player=1; player<=player_num; player++){
+        SequenceForm& sequence_form = sequence_form_strategies[player];
+        writer.Put((int64_t)sequence_form.strategy_idx_map.size());
+        for(auto& idx : sequence_form.strategy_idx_map) writer.Put((int64_t)idx);
+        writer.Put((int64_t)sequence_form.history_version_strategies.size());
+        for(auto& history : sequence_form.history_version_strategies){
+            writer.Put(history.timestep);
+            writer.Put(history.best_exploitability);
+            writer.Put(history.last_iterate);
+            writer.Put(history.best_iterate);
+            writer.Put(history.avg_iterate);
+            writer.Put(history.linear_avg_iterate);
+        }
+    }
+
+    writer.Put((int64_t)run_iterations);
+    writer.Put((int64_t)Is_Compensated_Summation);
+    writer.Put((int64_t)best_iterate_freq);
+    writer.Put((int64_t)best_iterate_candidates);
+    writer.Put((int64_t)best_iterate_trackers.size());
+    for(auto& tracker : best_iterate_trackers){
+        writer.Put((int64_t)tracker.num_updates);
+        writer.Put((int64_t)tracker.strategy_node_idx.size());
+        for(auto& idx : tracker.strategy_node_idx) writer.Put((int64_t)idx);
+        writer.Put((int64_t)tracker.candidate_proxy.size());
+        for(auto& proxy : tracker.candidate_proxy) writer.Put(proxy);
+    }
+    for(int player=1; player<=player_num; player++){
+        SequenceForm& sequence_form = sequence_form_strategies[player];
+        for(auto& history : sequence_form.history_version_strategies){
+            writer.Put((int64_t)history.candidates.size());
+            for(auto& candidate : history.candidates) writer.Put(candidate);
+        }
+        std::vector<std::string> names; // sorted, so that the same frozen strategies give the same blocks
+        for(auto& frozen : sequence_form.frozen_strategies) names.push_back(frozen.first);
+        std::sort(names.begin(), names.end());
+        writer.Put((int64_t)names.size());
+        for(auto& name : names){
+            writer.Put(name);
+            writer.Put(sequence_form.frozen_strategies[name]);
+        }
+    }
+    return Checkpoint::Save(file_name, player_num, StructureHash(infosets, player_num), GraphHash(graph), writer.payload);
+}
+
+void Environment::Load(const std::string& file_name){
+    /*
+        Restore the training state saved by Save. The environment should be built from the same game, and SetGraph should be called
+        with the same graph first. Random generators are not saved, call set_seed to make sampled traversals reproducible
+        The checkpoint is parsed and checked into temporaries first, so a failed Load leaves the environment unchanged
+    */
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if(!Flags_Initialized){
+        Initialize();
+    }
+    std::vector<std::vector<std::vector<std::vector<Vector>>>> results(player_num + 1); // results[player][infoset]
+    std::vector<std::vector<int>> strategy_idx_maps(player_num + 1);
+    std::vector<std::vector<HistoryVersionStrategy>> histories(player_num + 1);
+    std::vector<std::unordered_map<std::string, Vector>> frozen_strategies(player_num + 1);
+    int loaded_run_iterations = 0, loaded_freq = 1, loaded_candidates = 0;
+    bool is_compensated = false;
+    std::vector<BestIterateTracker> trackers;
+
+    std::lock_guard<std::mutex> evaluation_lock(evaluation_mutex);
+    Checkpoint::Load(file_name, player_num, StructureHash(infosets, player_num), GraphHash(graph), [&](CheckpointReader& reader){
+        auto GetSize = [&](const int64_t& expected){
+            int64_t size = reader.GetInt();
+            if(size < 0 || (expected >= 0 && size != expected))
+                throw std::runtime_error("Checkpoint does not match the environment: " + std::to_string(size) + " items, expected " + std::to_string(expected));
+            return size;
+        };
+        for(int player=1; player<=player_num; player++){
+            results[player].resize(infosets[player].size());
+            for(int i=0; i<infosets[player].size(); ++i){
+                results[player][i].resize(GetSize(infosets[player][i].results.size()));
+                for(auto& result : results[player][i]){
+                    result.resize(GetSize(-1));
+                    for(auto& value : result) reader.Get(value);
+                }
+            }
+        }
+        for(int player=1; player<=player_num; player++){
+            int strategy_size = sequence_form_strategies[player].strategy.size;
+            strategy_idx_maps[player].resize(GetSize(-1));
+            for(auto& idx : strategy_idx_maps[player]) idx = reader.GetInt();
+            histories[player].assign(GetSize(-1), HistoryVersionStrategy(strategy_size));
+            for(auto& history : histories[player]){
+                history.timestep = reader.GetDouble();
+                history.best_exploitability = reader.GetDouble();
+                reader.Get(history.last_iterate, strategy_size);
+                reader.Get(history.best_iterate, strategy_size);
+                reader.Get(history.avg_iterate, strategy_size);
+                reader.Get(history.linear_avg_iterate, strategy_size);
+            }
+            for(auto& idx : strategy_idx_maps[player])
+                if(idx < -1 || idx >= (int)histories[player].size())
+                    throw std::runtime_error("Checkpoint is corrupted: invalid index of history version");
+        }
+
+        loaded_run_iterations = reader.GetInt();
+        is_compensated = reader.GetInt();
+        loaded_freq = reader.GetInt();
+        loaded_candidates = reader.GetInt();
+        if(loaded_freq < 1 || loaded_candidates < 0)
+            throw std::runtime_error("Checkpoint is corrupted: invalid best-iterate tracking, eval_freq " + std::to_string(loaded_freq)
+                                     + " and num_candidates " + std::to_string(loaded_candidates));
+        trackers.assign(GetSize(-1), BestIterateTracker());
+        for(auto& tracker : trackers){
+            tracker.num_updates = reader.GetInt();
+            tracker.strategy_node_idx.resize(GetSize(player_num));
+            for(auto& idx : tracker.strategy_node_idx){
+                idx = reader.GetInt();
+                if(idx < 0 || idx >= (int)graph.graph_nodes.size()) throw std::runtime_error("Checkpoint is corrupted: invalid strategy node of best-iterate tracker");
+            }
+            tracker.candidate_proxy.resize(GetSize(-1));
+            if(tracker.candidate_proxy.size() > std::max(loaded_candidates, 1)) throw std::runtime_error("Checkpoint is corrupted: too many best-iterate candidates");
+            for(auto& proxy : tracker.candidate_proxy) proxy = reader.GetDouble();
+        }
+        for(int player=1; player<=player_num; player++){
+            int strategy_size = sequence_form_strategies[player].strategy.size;
+            for(auto& history : histories[player]){
+                history.candidates.resize(GetSize(-1));
+                for(auto& candidate : history.candidates) reader.Get(candidate, strategy_size);
+            }
+            for(int64_t i=GetSize(-1); i>0; --i){
+                std::string name = reader.GetString();
+                reader.Get(frozen_strategies[player][name], strategy_size);
+            }
+        }
+
+        // VerifyBestIterate reads the candidates of every pending slot from the history of each player
+        for(auto& tracker : trackers){
+            for(int player=1; player<=player_num; player++){
+                int idx = tracker.strategy_node_idx[player-1];
+                int history_idx = (idx < strategy_idx_maps[player].size()) ? strategy_idx_maps[player][idx] : -1;
+                int stored = (history_idx == -1) ? 0 : histories[player][history_idx].candidates.size();
+                if(stored < tracker.candidate_proxy.size()) throw std::runtime_error("Checkpoint is corrupted: best-iterate candidates are missing");
+            }
+        }
+    });
+
+    for(int player=1; player<=player_num; player++){
+        for(int i=0; i<infosets[player].size(); ++i) infosets[player][i].results.swap(results[player][i]);
+        SequenceForm& sequence_form = sequence_form_strategies[player];
+        sequence_form.strategy_idx_map.swap(strategy_idx_maps[player]);
+        sequence_form.history_version_strategies.swap(histories[player]);
+        sequence_form.frozen_strategies.swap(frozen_strategies[player]);
     }
+    run_iterations = loaded_run_iterations;
+    Is_Compensated_Summation = is_compensated;
+    for(auto& sequence_form : sequence_form_strategies) sequence_form.is_compensated = Is_Compensated_Summation;
+    best_iterate_freq = loaded_freq;
+    best_iterate_candidates = loaded_candidates;
+    best_iterate_trackers.swap(trackers);
 }
 
 Environment::~Environment(){
-    delete nodes[0]; // only the root node is defined by new and needs to be deleted
+    if(Flags_Initialized && !nodes.empty()) delete nodes[0]; // only the root node added by Initialize is defined by new and needs to be deleted
 }
\ No newline at end of file
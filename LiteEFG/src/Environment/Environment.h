@@ -6,8 +6,50 @@
 #include "Environment/Infoset.h"
 #include "Environment/SequenceForm.h"
 
+#include <cstdint>
+#include <functional>
+#include <future>
 #include <vector>
 #include <map>
+#include <mutex>
+
+class BestIterateTracker{
+public:
+    std::vector<int> strategy_node_idx; // strategy node used by each player
+    std::vector<double> candidate_proxy; // proxy of each candidate slot waiting to be verified
+    int num_updates = 0;
+};
+
+class UpdateStep{
+public:
+    /*
+        One call of Environment::Update in the schedule of Environment::Run, with one strategy node shared by all players or one per player
+        It is called at iteration t if start <= t, t <= stop (no limit if stop <= 0), and t % period is in phases
+        phases are stored as sorted ranges [first, second), so a long period with most of its phases active takes little memory
+    */
+    std::vector<GraphNode> strategy_nodes;
+    int upd_player, period, start, stop;
+    std::vector<int> upd_color;
+    std::vector<std::pair<int, int>> phases;
+    std::string traverse_type;
+
+    UpdateStep(const std::vector<GraphNode>& strategy_nodes_, const int& upd_player_=-1, const std::vector<int>& upd_color_={-1},
+               const std::string& traverse_type_="default", const int& period_=1, const std::vector<int>& phases_={0},
+               const int& start_=1, const int& stop_=0);
+    bool IsActive(const int& iteration) const;
+};
+
+class ExploitabilityFuture{
+public:
+    /*
+        Exploitability computed by Environment::ExploitabilityAsync on a background thread
+        The environment should outlive the future, Python keeps it alive while the future exists
+    */
+    std::shared_future<std::vector<double>> future;
+
+    bool Done() const;
+    std::vector<double> Get() const;
+};
 
 class Environment{
 public:
@@ -22,50 +64,102 @@ public:
     std::vector<std::vector<Infoset>> infosets;
     std::vector<Infoset*> traverse_infoset;
     std::vector<SequenceForm> sequence_form_strategies;
-    std::vector<std::vector<std::string>> infoset_names;
+    std::vector<InfosetNames> infoset_names;
 
-    bool Flags_Initialized = false, Is_Aggregate_Opponents = false;
+    bool Flags_Initialized = false, Is_Aggregate_Opponents = false, Is_Compensated_Summation = false;
     int traverse;
 
-    Graph graph;
+    Graph graph{false};
     std::map<int, int> color_mapping;
     int num_colors;
     std::vector<bool> is_color_to_update;
 
+    int best_iterate_freq = 1, best_iterate_candidates = 0;
+    std::vector<BestIterateTracker> best_iterate_trackers;
+    int run_iterations = 0; // iterations done by Run since the last SetGraph, can be set to continue the count of a Python loop
+    std::recursive_mutex mutex; // held by the public entry points, which run with the GIL released
+    std::mutex evaluation_mutex; // held while accumulating gradients, which share the walk buffers with the background evaluations
+
     Environment(const int& player_num_, const std::string& traverse_="Enumerate");
 
     void SetGraph(const Graph& graph_);
+    void SetCompensatedSummation(const bool& is_compensated);
 
     virtual void Initialize();
+    void InitializeInfosets();
     double GetProb(Node* node, const int& strategy_node_idx, const int& action);
     Vector* GetProb(Node* node, const int& strategy_node_idx);
 
     void AggregateInformation(Infoset& infoset, const bool& is_parent, const int& node_status);
+    virtual void GetTraverseOrder(const int& current_traverse, const std::vector<GraphNode>& strategy_nodes, const int& traverser);
+    virtual void WalkTerminals(const std::function<void(const double&, const std::vector<std::pair<int, int>>&, const double*)>& func);
     void UpdateTraverse(const int& upd_player);
+    virtual void AccumulateUtility(const int& upd_player);
     void Update(const GraphNode& strategy_node, const int& upd_player=-1, std::vector<int> upd_color={-1}, const std::string& traverse_type="default");
     void Update(std::vector<GraphNode> strategy_nodes, const int& upd_player=-1, std::vector<int> upd_color={-1}, const std::string& traverse_type="default");
     
     void UpdateStrategy(const GraphNode& strategy_node, const bool& update_best=false);
     void UpdateStrategy(const std::vector<GraphNode>& strategy_node, const bool& update_best=false);
+    std::vector<std::pair<int, std::vector<double>>> Run(const std::vector<UpdateStep>& schedule, const int& iterations, const GraphNode& strategy_node,
+                                                         const std::string& type_name="default", const int& eval_every=0, const bool& update_best=false,
+                                                         const int& update_strategy_every=1);
+    std::vector<std::pair<int, std::vector<double>>> Run(const std::vector<UpdateStep>& schedule, const int& iterations, const std::vector<GraphNode>& strategy_nodes,
+                                                         const std::string& type_name="default", const int& eval_every=0, const bool& update_best=false,
+                                                         const int& update_strategy_every=1);
+    void SetBestIterateTracking(const int& eval_freq, const int& num_candidates=0);
+    BestIterateTracker& GetBestIterateTracker(const std::vector<GraphNode>& strategy_nodes);
+    void AddBestIterateCandidate(const std::vector<GraphNode>& strategy_nodes);
+    void VerifyBestIterate();
     
     std::vector<double> GetSequenceFormStrategy(const int& player, const GraphNode& strategy_node);
 
     //double Exploitability(const std::vector<SequenceForm>& sequence_form_strategies);
+    void PrepareSequenceFormStrategies(const std::vector<GraphNode>& strategy_nodes, const std::string& type_name="default");
     void GetGradient(const std::vector<GraphNode>& strategy_node, const std::string& type_name="default");
-    
+    virtual void ComputeGradient(std::vector<SequenceForm>& sequence_forms);
+
     std::vector<double> Utility(const GraphNode& strategy_node, const std::string& type_name="default");
     std::vector<double> Utility(const std::vector<GraphNode>& strategy_node, const std::string& type_name="default");
 
     std::vector<double> Exploitability(const GraphNode& strategy_node, const std::string& type_name="default");
     std::vector<double> Exploitability(const std::vector<GraphNode>& strategy_node, const std::string& type_name="default");
+    ExploitabilityFuture ExploitabilityAsync(const GraphNode& strategy_node, const std::string& type_name="default");
+    ExploitabilityFuture ExploitabilityAsync(const std::vector<GraphNode>& strategy_node, const std::string& type_name="default");
+
+    void GetBatchGradient(const std::vector<std::vector<GraphNode>>& strategy_nodes, const std::vector<std::string>& type_names);
+    void ComputeBatchGradient();
+
+    std::vector<std::vector<double>> BatchUtility(const std::vector<GraphNode>& strategy_nodes, const std::vector<std::string>& type_names);
+    std::vector<std::vector<double>> BatchUtility(const std::vector<std::vector<GraphNode>>& strategy_nodes, const std::vector<std::string>& type_names);
+
+    std::vector<std::vector<double>> BatchExploitability(const std::vector<GraphNode>& strategy_nodes, const std::vector<std::string>& type_names);
+    std::vector<std::vector<double>> BatchExploitability(const std::vector<std::vector<GraphNode>>& strategy_nodes, const std::vector<std::string>& type_names);
+
+    void LoadStrategy(const std::string& name, const int& player, const std::vector<double>& strategy);
+    void FreezeStrategy(const std::string& name, const GraphNode& strategy_node, const std::string& type_name="default");
+    std::vector<std::vector<double>> CrossPlayUtility(const std::vector<std::vector<std::string>>& profiles);
+    std::vector<std::vector<std::vector<double>>> MatchupMatrix(const std::vector<std::string>& row_names, const std::vector<std::string>& col_names);
 
     std::vector<std::pair<std::string, std::vector<double>> > GetValue(const int& player, const GraphNode& node);
     std::vector<std::pair<std::string, std::vector<double>> > GetStrategy(const int& player, const GraphNode& strategy_node, const std::string& type_name="default");
 
+    FlatValues GetFlatValue(const int& player, const GraphNode& node);
+    FlatValues GetFlatStrategy(const int& player, const GraphNode& strategy_node, const std::string& type_name="default");
+    std::vector<std::string> GetInfosetNames(const int& player, const std::vector<int>& indices={});
+
     void SetValue(const int& player, const GraphNode& node, const std::vector<std::vector<double>>& values);
     void SetValue(const int& player, const GraphNode& node, const std::vector<double>& values);
+    void SetValue(const int& player, const GraphNode& node, const double* values, const size_t& size);
+
+    SparseStrategy GetSparseStrategy(const int& player, const GraphNode& strategy_node, const std::string& type_name="default", const double& threshold=0.0);
+    void SetSparseValue(const int& player, const GraphNode& node, const SparseStrategy& values);
+    void ExportStrategy(const std::string& file_name, const GraphNode& strategy_node, const std::string& type_name="default", const double& threshold=0.0,
+                        const std::string& codec="default", const int& num_threads=0);
+
+    int64_t Save(const std::string& file_name);
+    void Load(const std::string& file_name);
 
-    ~Environment();
+    virtual ~Environment();
 };
 
 #endif
\ No newline at end of file
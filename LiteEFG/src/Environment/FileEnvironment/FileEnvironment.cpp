@@ -3,207 +3,655 @@
 #include "Basic/FileReader.h"
 #include "Basic/BasicFunction.h"
 
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <system_error>
 
 FileNode::FileNode(const int& player_, const int& infoset_, const int& player_num_) : Node(player_, infoset_, player_num_) {
     utility = std::vector<double>(player_num_+1, 0.0);
-    actions.clear();
-    is_root = true;
 }
 
 double FileNode::GetUtility(const int& player){
     return utility[player];
 }
 
-void FileEnvironment::GetNextNode(const bool& is_openspiel){
-    std::string name;
-    if(!is_openspiel){
-        for(auto& node : file_nodes){
-            node.next_node.clear();
-            for(int i=0; i<node.actions.size(); ++i){
-                name = (node.name.back() == '/') ? node.name : node.name + '/';
-                name = (node.player == 0) ? name + "C:" : name + 'P' + std::to_string(node.player) + ':';
-                name += node.actions[i];
-                node.next_node.push_back(node_map[name]);
-            }
-        }
-    } else{
-        for(auto& node : file_nodes){
-            node.next_node.clear();
-            for(int i=0; i<node.actions.size(); ++i){
-                node.next_node.push_back(node_map[node.actions[i]]);
-            }
-        }
-    }
+template <typename T>
+static void AppendAndRelease(std::vector<T>& a, std::vector<T>& b){
+    a.insert(a.end(), b.begin(), b.end());
+    std::vector<T>().swap(b);
 }
 
-FileEnvironment::FileEnvironment(const std::string& file_name_, const std::string& traverse_)
-                                : Environment(0, traverse_), file_reader(file_name_), node_num(0), infoset_num(0){
-    // Constructor. Constructor of Environment will be re-called at the end of this constructor
-    // Read the game tree from file
-    // The file should be in the format of the game tree
+static void AppendPointer(std::vector<int>& a, std::vector<int>& b){
+    // b is a pointer array starting with 0, shifted by the last element of a
+    int offset = a.back();
+    for(int i=1; i<b.size(); ++i) a.push_back(b[i] + offset);
+    std::vector<int>().swap(b);
+}
 
-    file_nodes.clear();
-    node_map.clear();
-    infoset_map.clear();
-    
-    std::string name, player_name, temp_name;
-    char c;
-    bool is_openspiel = false;
-    
-    player_num = -1;
-    while((c=file_reader.Read()) == '#'){ // Jump the descriptions of the game
-        file_reader.NextWord();
-        char cc = file_reader.GetWord(name);
-        if(name == "num_players:" || name == "players:"){
-            cc = file_reader.GetWord(name);
-            name = name.substr(0, name.size()-1);
-            player_num = std::stoi(name);
-        } else if(name == "openspiel,"){
-            is_openspiel = true;
-        } else if(name == "}"){
-            break;
-        }
-        if(cc != '\n') file_reader.NextLine();
-    }
-    while((c=file_reader.Read()) == '#')
-        file_reader.NextLine();
+void FileTree::Append(FileTree& chunk){
+    /*
+        Move the nodes in chunk to the end of this tree and release them from chunk
+        Infosets stay in chunk, since they are resolved after all nodes are known
+    */
+    AppendAndRelease(names, chunk.names);
+    AppendAndRelease(players, chunk.players);
+    AppendAndRelease(actions, chunk.actions);
+    AppendAndRelease(values, chunk.values);
+    AppendPointer(action_ptr, chunk.action_ptr);
+    AppendPointer(value_ptr, chunk.value_ptr);
+}
 
-    if(player_num == -1) throw std::runtime_error("Please specify the number of players at the beginning of the file");
-    infoset_names.resize(player_num+1);
-    infoset_names_backup.resize(player_num+1);
-    infoset_num = std::vector<int>(player_num+1, 0);
-    
-    while(true){
+void FileEnvironment::ParseChunk(FileCursor reader, FileTree& chunk){
+    /*
+        Parse the node and infoset descriptions in [reader.cursor, reader.file_end), which should be line-aligned
+        Infosets only store the names of their nodes here, they are resolved after all chunks are parsed
+    */
+    std::string_view name, player_name;
+    char c;
+    while((c = reader.Read()) != EOF){
         if(c == 'n'){ // node description
-            file_reader.NextWord();
-            file_reader.GetWord(name); // get the name of the node
+            reader.NextWord();
+            reader.GetWord(name); // get the name of the node
+            chunk.names.push_back(name);
 
-            node_map[name] = node_num++;
-            file_nodes.push_back(FileNode(0, 0, player_num));
-            FileNode& node = file_nodes.back();
-            node.name = name;
-
-            char cc = file_reader.Read();
-            file_reader.NextWord();
+            int player = 0;
+            char cc = reader.Read();
+            reader.NextWord();
             if(cc == 'c') { // chance node
                 /*
                     Example (Kuhn Poker): 
                     node / chance actions 12=0.16666667 13=0.16666667 21=0.16666667 23=0.16666667 31=0.16666667 32=0.16666667
                 */
-                node.player = 0;
-                file_reader.NextWord(); // Skip "actions"
+                reader.NextWord(); // Skip "actions"
+                size_t start = chunk.values.size();
+                double sum = 0.0;
                 char ccc;
                 while(true){
-                    ccc=file_reader.GetWord(name);
-                    node.actions.push_back(Basic::GetSlice(name, 0, '='));
-                    std::string& action = node.actions.back();
-                    double prob = std::stod(Basic::GetSlice(name, action.size()+1, '\n'));
-                    node.chance.push_back(prob);
-                    if(ccc == '\n') break;
+                    ccc = reader.GetWord(name);
+                    std::string_view action = Basic::GetSlice(name, 0, '=');
+                    chunk.actions.push_back(action);
+                    chunk.values.push_back(Basic::ParseDouble(name.substr(std::min(action.size()+1, name.size()))));
+                    sum += chunk.values.back();
+                    if(ccc == '\n' || ccc == EOF) break;
                 }
-                node.chance.Div(node.chance.Sum());
+                for(size_t i=start; i<chunk.values.size(); ++i) chunk.values[i] /= sum;
             } else if(cc == 'p') { // player node
                 /*
                     Example (Kuhn Poker):
                     node /C:12 player 1 actions k b
                 */
-                file_reader.GetWord(player_name);
-                node.player = std::stoi(player_name);
+                reader.GetWord(player_name);
+                player = Basic::ParseInt(player_name);
 
-                file_reader.NextWord(); // Skip "actions"
+                reader.NextWord(); // Skip "actions"
 
                 char ccc;
                 while(true){
-                    ccc = file_reader.GetWord(name);
-                    node.actions.push_back(name);
-                    if(ccc == '\n') break;
+                    ccc = reader.GetWord(name);
+                    chunk.actions.push_back(name);
+                    if(ccc == '\n' || ccc == EOF) break;
                 }
             } else if(cc == 'l') { // terminal node
                 /*
                     Example (Kuhn Poker):
                     node /C:12/P1:k/P2:k leaf payoffs 1=-1 2=1
                 */
-                file_reader.NextWord();
-                int player = 0;
+                reader.NextWord();
+                size_t start = chunk.values.size();
+                chunk.values.resize(start + player_num, 0.0);
 
                 char ccc;
                 while(true){
-                    ccc = file_reader.GetWord(name);
+                    ccc = reader.GetWord(name);
                     player_name = Basic::GetSlice(name, 0, '=');
-                    player = std::stoi(player_name);
-                    node.utility[player] = std::stod(Basic::GetSlice(name, player_name.size() + 1, '\n'));
-                    if(ccc == '\n') break;
+                    int payoff_player = Basic::ParseInt(player_name);
+                    if(payoff_player < 1 || payoff_player > player_num) throw std::runtime_error("Payoff of player " + std::string(player_name) + " is out of range in node " + std::string(chunk.names.back()));
+                    chunk.values[start + payoff_player-1] = Basic::ParseDouble(name.substr(std::min(player_name.size()+1, name.size())));
+                    if(ccc == '\n' || ccc == EOF) break;
                 }
             } else{
                 throw std::runtime_error("Unknown node type, only supports [\"chance\", \"player\", \"leaf\"]");
             }
+            chunk.players.push_back(player);
+            chunk.action_ptr.push_back(chunk.actions.size());
+            chunk.value_ptr.push_back(chunk.values.size());
         } 
         else if(c == 'i'){ // infoset description
             /*
                 Example (Kuhn Poker):
                 infoset pl1_0__1?/ nodes /C:12 /C:13 
             */
-            file_reader.NextWord();
-            file_reader.GetWord(temp_name);
-            file_reader.NextWord();
+            reader.NextWord();
+            reader.GetWord(name);
+            chunk.infoset_names.push_back(name);
+            reader.NextWord();
 
             char ccc;
-            int player;
             while(true){
-                ccc = file_reader.GetWord(name);
-                auto it = node_map.find(name);
-                if(it == node_map.end()) throw std::runtime_error("Please specify all nodes before defining infosets: Infoset: " + temp_name + " Node: " + name);
-                player = file_nodes[it -> second].player;
-                file_nodes[it -> second].infoset = infoset_num[player] + 1;
-                if(ccc == '\n' || ccc == EOF) {++infoset_num[player]; break;}
+                ccc = reader.GetWord(name);
+                if(name.size() > 0) chunk.infoset_nodes.push_back(name);
+                if(ccc == '\n' || ccc == EOF) break;
             }
-            infoset_names_backup[player].push_back(temp_name);
+            chunk.infoset_ptr.push_back(chunk.infoset_nodes.size());
         }
-        else break;
-        c = file_reader.Read();
+        else if(c != '\n') reader.NextLine(); // skip comments and blank lines
     }
+}
 
-    for(auto& node : file_nodes){
-        if(node.player !=0 && node.infoset == 0) {
-            node.infoset = ++infoset_num[node.player];
-            infoset_names_backup[node.player].push_back("pl"+std::to_string(node.player)+"_"+std::to_string(infoset_num[node.player])+"__singleton");
+void FileEnvironment::BuildNodeMap(){
+    /*
+        Each thread builds the partition of node_map containing the names whose hash equals its index modulo the number of partitions
+    */
+    const std::vector<std::string_view>& names = file_tree.names;
+    std::vector<size_t> hash(names.size());
+    Basic::ParallelFor(num_threads, [&](const int& thread_idx){
+        for(size_t i=thread_idx; i<names.size(); i+=num_threads)
+            hash[i] = std::hash<std::string_view>()(names[i]) % num_threads;
+    });
+    node_map.assign(num_threads, std::unordered_map<std::string_view, int>());
+    Basic::ParallelFor(num_threads, [&](const int& thread_idx){
+        auto& partition = node_map[thread_idx];
+        partition.reserve(names.size() / num_threads + 1);
+        for(size_t i=0; i<names.size(); ++i) if(hash[i] == (size_t)thread_idx){
+            if(!partition.emplace(names[i], i).second)
+                throw std::runtime_error("Node " + std::string(names[i]) + " is defined more than once");
         }
-        // sometimes singleton infosets are not mentioned in the file, so we need to add them manually
+    });
+}
+
+int FileEnvironment::FindNode(const std::string_view& name){
+    // Return the index of the node in file_tree, or -1 if no such node
+    auto& partition = node_map[std::hash<std::string_view>()(name) % node_map.size()];
+    auto it = partition.find(name);
+    return (it == partition.end()) ? -1 : it->second;
+}
+
+static std::string_view GetActionOfSegment(const std::string_view& segment){
+    // segment is "C:action" or "P<player>:action"
+    size_t pos = segment.find(':');
+    return (pos == std::string_view::npos) ? std::string_view() : segment.substr(pos+1);
+}
+
+static bool IsSegmentOfPlayer(const std::string_view& segment, const int& player){
+    if(player == 0) return segment.size() >= 2 && segment[0] == 'C' && segment[1] == ':';
+    size_t pos = segment.find(':');
+    if(segment.empty() || segment[0] != 'P' || pos == std::string_view::npos) return false;
+    int segment_player = -1;
+    auto result = std::from_chars(segment.data() + 1, segment.data() + pos, segment_player);
+    return result.ec == std::errc() && result.ptr == segment.data() + pos && segment_player == player;
+}
+
+void FileEnvironment::GetNextNode(const bool& is_openspiel){
+    /*
+        Fill file_tree.next_ptr and file_tree.next, i.e. the child reached by each action
+        For non-OpenSpiel files, the name of a child is parent + '/' + (C: or P<player>:) + action
+        Instead of building the name of every child and looking it up, each node finds its parent once by the prefix of its name,
+        i.e. the prefix is interned as the index of the parent. Children of each node are then sorted by action,
+        so linking hashes every name once and does not create any string
+    */
+    const std::vector<std::string_view>& names = file_tree.names;
+    const std::vector<std::string_view>& actions = file_tree.actions;
+    const std::vector<int>& action_ptr = file_tree.action_ptr;
+    int num = names.size();
+    file_tree.next_ptr = action_ptr;
+    file_tree.next.assign(actions.size(), -1);
+
+    if(is_openspiel){
+        Basic::ParallelFor(num_threads, [&](const int& thread_idx){
+            for(int i=actions.size()*(long long)thread_idx/num_threads; i<actions.size()*(long long)(thread_idx+1)/num_threads; ++i){
+                file_tree.next[i] = FindNode(actions[i]);
+                if(file_tree.next[i] == -1) throw std::runtime_error("Node " + std::string(actions[i]) + " is not defined");
+            }
+        });
+        return;
     }
-    GetNextNode(is_openspiel);
 
-    for(auto& node : file_nodes){
-        for(int i=0; i<node.next_node.size(); ++i){
-            file_nodes[node.next_node[i]].is_root = false;
+    std::vector<int> parent(num, -1);
+    Basic::ParallelFor(num_threads, [&](const int& thread_idx){
+        for(int k=num*(long long)thread_idx/num_threads; k<num*(long long)(thread_idx+1)/num_threads; ++k){
+            std::string_view name = names[k];
+            size_t pos = name.rfind('/');
+            if(pos == std::string_view::npos) continue;
+            parent[k] = (pos > 0) ? FindNode(name.substr(0, pos)) : -1;
+            if(parent[k] == -1) parent[k] = FindNode(name.substr(0, pos+1)); // parent whose name ends with '/', e.g. the root "/"
+        }
+    });
+
+    // children[children_ptr[k]], ..., children[children_ptr[k+1]-1] are the nodes whose parent is k, sorted by action
+    std::vector<int> children_ptr(num+1, 0), children(num);
+    for(int k=0; k<num; ++k) if(parent[k] != -1) ++children_ptr[parent[k]+1];
+    for(int k=0; k<num; ++k) children_ptr[k+1] += children_ptr[k];
+    std::vector<int> position(children_ptr.begin(), children_ptr.end()-1);
+    for(int k=0; k<num; ++k) if(parent[k] != -1) children[position[parent[k]]++] = k;
+    std::vector<int>().swap(parent);
+    std::vector<int>().swap(position);
+
+    Basic::ParallelFor(num_threads, [&](const int& thread_idx){
+        std::string name;
+        auto action_of = [&](const int& idx){
+            return GetActionOfSegment(names[idx].substr(names[idx].rfind('/')+1));
+        };
+        for(int k=num*(long long)thread_idx/num_threads; k<num*(long long)(thread_idx+1)/num_threads; ++k){
+            int player = file_tree.players[k];
+            auto first = children.begin() + children_ptr[k], last = children.begin() + children_ptr[k+1];
+            std::sort(first, last, [&](const int& a, const int& b){ return action_of(a) < action_of(b); });
+
+            for(int i=action_ptr[k]; i<action_ptr[k+1]; ++i){
+                auto it = std::lower_bound(first, last, actions[i], [&](const int& a, const std::string_view& action){ return action_of(a) < action; });
+                for(; it != last && action_of(*it) == actions[i]; ++it){
+                    if(IsSegmentOfPlayer(names[*it].substr(names[*it].rfind('/')+1), player)) break;
+                }
+                if(it != last && action_of(*it) == actions[i]) file_tree.next[i] = *it;
+                else{ // fall back to the full name, e.g. when the action contains '/'
+                    name = names[k];
+                    if(name.empty() || name.back() != '/') name += '/';
+                    if(player == 0) name += "C:";
+                    else name += 'P' + std::to_string(player) + ':';
+                    name += actions[i];
+                    file_tree.next[i] = FindNode(name);
+                    if(file_tree.next[i] == -1) throw std::runtime_error("Node " + name + " is not defined, which is a child of node " + std::string(names[k]));
+                }
+            }
+        }
+    });
+}
+
+void FileEnvironment::BuildNodes(){
+    /*
+        Build file_nodes from file_tree in the BFS order of the game tree, so that parent is always before children
+    */
+    const FileTree& tree = file_tree;
+    std::vector<bool> is_root(node_num, true);
+    for(auto& next : tree.next) is_root[next] = false;
+    int root = std::find(is_root.begin(), is_root.end(), true) - is_root.begin();
+    if(root == node_num) throw std::runtime_error("No root node found");
+
+    std::vector<int> order(1, root), position(node_num, -1); // order[i] is the i-th node in BFS order, position is its inverse
+    position[root] = 0;
+    for(int i=0; i<order.size(); ++i){
+        for(int j=tree.next_ptr[order[i]]; j<tree.next_ptr[order[i]+1]; ++j){
+            int next = tree.next[j];
+            if(position[next] != -1) throw std::runtime_error("Node " + std::string(tree.names[next]) + " has more than one parent");
+            position[next] = order.size();
+            order.push_back(next);
         }
     }
-    int root=0;
-    for(root=0; root<file_nodes.size(); ++root){
-        if(file_nodes[root].is_root) break;
+    if(order.size() != node_num)
+        throw std::runtime_error("Some nodes are not connected to the tree");
+
+    file_nodes.reserve(node_num);
+    for(int i=0; i<node_num; ++i){
+        int k = order[i];
+        file_nodes.push_back(FileNode(tree.players[k], tree.infosets[k], player_num));
+        FileNode& node = file_nodes.back();
+        for(int j=tree.next_ptr[k]; j<tree.next_ptr[k+1]; ++j) node.next_node.push_back(position[tree.next[j]]);
+        if(node.next_node.size() == 0){
+            for(int p=1; p<=player_num; ++p) node.utility[p] = tree.values[tree.value_ptr[k] + p-1];
+        } else if(node.player == 0){
+            for(int j=tree.value_ptr[k]; j<tree.value_ptr[k+1]; ++j) node.chance.push_back(tree.values[j]);
+        }
+        nodes.push_back(&node);
+    }
+}
+
+FileEnvironment::FileEnvironment(const std::string& file_name_, const std::string& traverse_, const int& num_threads_, const bool& keep_infoset_names)
+                                : Environment(0, traverse_), file_reader(file_name_, Basic::GetNumThreads(num_threads_)), node_num(0), num_threads(Basic::GetNumThreads(num_threads_)), 
+                                  Is_Keep_Infoset_Names(keep_infoset_names), infoset_num(0){
+    // Constructor. Constructor of Environment will be re-called at the end of this constructor
+    // Read the game tree from file
+    // The file should be in the format of the game tree
+    // Only the game tree is kept after loading, the file, node names and actions are released
+
+    file_nodes.clear();
+    node_map.clear();
+
+    if(file_reader.file_size >= sizeof(BinaryGameHeader) && memcmp(file_reader.data, binary_magic, 8) == 0){
+        LoadBinary();
+        file_reader.Close();
+        return;
     }
-    if(root == file_nodes.size()) throw std::runtime_error("No root node found");
     
-    nodes.push_back(&file_nodes[root]);
-    node_map[file_nodes[root].name] = 0;
-    for(int i=0; i<nodes.size(); ++i){
-        for(int j=0; j<nodes[i]->next_node.size(); ++j){
-            nodes.push_back(&file_nodes[nodes[i]->next_node[j]]);
-            node_map[file_nodes[nodes[i]->next_node[j]].name] = nodes.size()-1;
+    std::string_view name;
+    char c;
+    bool is_openspiel = false;
+    
+    player_num = -1;
+    while((c=file_reader.Read()) == '#'){ // Jump the descriptions of the game
+        file_reader.NextWord();
+        char cc = file_reader.GetWord(name);
+        if(name == "num_players:" || name == "players:"){
+            cc = file_reader.GetWord(name);
+            player_num = Basic::ParseInt(name.substr(0, name.size()-1));
+        } else if(name == "openspiel,"){
+            is_openspiel = true;
+        } else if(name == "}"){
+            break;
         }
+        if(cc != '\n') file_reader.NextLine();
     }
-    if(nodes.size() != node_num)
-        throw std::runtime_error("Some nodes are not connected to the tree");
+    while((c=file_reader.Read()) == '#')
+        file_reader.NextLine();
+
+    if(player_num == -1) throw std::runtime_error("Please specify the number of players at the beginning of the file");
+    infoset_names.resize(player_num+1);
+    infoset_names_backup.resize(player_num+1);
+    infoset_num = std::vector<int>(player_num+1, 0);
+
+    /*
+        Split the rest of the file into line-aligned chunks, one per thread, at least 1MB each
+        Nodes of each chunk are appended in order, so the node order is the same as that in the file
+    */
+    const char* body = (c == EOF) ? file_reader.file_end : file_reader.cursor - 1;
+    int num_chunks = std::max((size_t)1, std::min((size_t)num_threads, (size_t)(file_reader.file_end - body) >> 20));
+    std::vector<const char*> boundary(num_chunks+1, file_reader.file_end);
+    boundary[0] = body;
+    for(int i=1; i<num_chunks; ++i){
+        const char* pos = std::max(boundary[i-1], body + (file_reader.file_end - body) / num_chunks * i);
+        while(pos != file_reader.file_end && *pos != '\n') ++pos;
+        boundary[i] = (pos == file_reader.file_end) ? pos : pos + 1;
+    }
+    std::vector<FileTree> chunks(num_chunks);
+    Basic::ParallelFor(num_chunks, [&](const int& chunk_idx){
+        ParseChunk(FileCursor(boundary[chunk_idx], boundary[chunk_idx+1]), chunks[chunk_idx]);
+    });
+    for(auto& chunk : chunks) file_tree.Append(chunk);
+    node_num = file_tree.names.size();
+    BuildNodeMap();
 
+    Basic::ParallelFor(num_chunks, [&](const int& chunk_idx){ // resolve the nodes of each infoset
+        FileTree& chunk = chunks[chunk_idx];
+        chunk.infoset_node_idx.resize(chunk.infoset_nodes.size());
+        for(int i=0; i+1<chunk.infoset_ptr.size(); ++i){
+            for(int j=chunk.infoset_ptr[i]; j<chunk.infoset_ptr[i+1]; ++j){
+                chunk.infoset_node_idx[j] = FindNode(chunk.infoset_nodes[j]);
+                if(chunk.infoset_node_idx[j] == -1)
+                    throw std::runtime_error("Node " + std::string(chunk.infoset_nodes[j]) + " in infoset " + std::string(chunk.infoset_names[i]) + " is not defined");
+            }
+        }
+    });
+    file_tree.infosets.assign(node_num, 0);
+    for(auto& chunk : chunks){
+        for(int i=0; i+1<chunk.infoset_ptr.size(); ++i){
+            int player = 0;
+            for(int j=chunk.infoset_ptr[i]; j<chunk.infoset_ptr[i+1]; ++j){
+                int k = chunk.infoset_node_idx[j];
+                player = file_tree.players[k];
+                file_tree.infosets[k] = infoset_num[player] + 1;
+            }
+            ++infoset_num[player];
+            infoset_names_backup[player].push_back(chunk.infoset_names[i]);
+        }
+        chunk = FileTree();
+    }
+
+    for(int k=0; k<node_num; ++k){
+        int player = file_tree.players[k];
+        if(player != 0 && file_tree.infosets[k] == 0) {
+            file_tree.infosets[k] = ++infoset_num[player];
+            infoset_names_backup[player].push_back(std::string_view());
+        }
+        // sometimes singleton infosets are not mentioned in the file, so we need to add them manually
+    }
     GetNextNode(is_openspiel);
-    for(int i=0; i<=player_num; ++i) infoset_num[i] = 0;
+    node_map = std::vector<std::unordered_map<std::string_view, int>>();
+    BuildNodes();
+    file_tree = FileTree();
+    RenumberInfosets();
+    file_reader.Close();
+}
+
+FileEnvironment::FileEnvironment(const int& player_num_, std::vector<int> players, std::vector<int> infosets, std::vector<int> next_ptr, std::vector<int> next,
+                                 const std::vector<double>& chance, const std::vector<double>& payoffs, const std::vector<std::vector<std::string>>& infoset_names_,
+                                 const std::string& traverse_)
+                                : Environment(player_num_, traverse_), node_num(players.size()), num_threads(1), Is_Keep_Infoset_Names(true){
+    /*
+        Build the game from flat arrays instead of a file, e.g. from a game tree exported by OpenSpiel
+        players[k], infosets[k]: player (0 for chance) and its infoset index (starting from 1) of node k, ignored for leaves
+        next[next_ptr[k]], ..., next[next_ptr[k+1]-1]: children of node k, where chance[j] is the probability to reach next[j] if k is a chance node
+        payoffs[k * player_num], ..., payoffs[k * player_num + player_num-1]: payoffs of leaf k
+        infoset_names_[player-1][i-1]: name of the infoset i of player, singleton names are used if not given
+    */
+    if(player_num < 1) throw std::invalid_argument("num_players should be positive");
+    if(infosets.size() != node_num || next_ptr.size() != node_num+1)
+        throw std::invalid_argument("players and infosets should have num_nodes elements, and next_ptr should have num_nodes+1 elements");
+    if(next_ptr[0] != 0 || next_ptr[node_num] != next.size() || chance.size() != next.size())
+        throw std::invalid_argument("next_ptr should start from 0 and end with the size of next, which should be equal to the size of chance");
+    if(payoffs.size() != (size_t)node_num * player_num) throw std::invalid_argument("payoffs should have num_nodes * num_players elements");
+    if(infoset_names_.size() != 0 && infoset_names_.size() != player_num) throw std::invalid_argument("infoset_names should be empty or have num_players lists");
+
+    infoset_names.resize(player_num+1);
+    infoset_names_backup.resize(player_num+1);
+    infoset_num = std::vector<int>(player_num+1, 0);
+    file_tree.value_ptr.reserve(node_num+1);
+    for(int k=0; k<node_num; ++k){
+        if(next_ptr[k] > next_ptr[k+1]) throw std::invalid_argument("next_ptr should be non-decreasing");
+        if(next_ptr[k] == next_ptr[k+1]){ // leaf
+            players[k] = infosets[k] = 0;
+            file_tree.values.insert(file_tree.values.end(), payoffs.begin() + (size_t)k * player_num, payoffs.begin() + (size_t)(k+1) * player_num);
+        } else if(players[k] == 0){
+            double sum = 0.0;
+            for(int j=next_ptr[k]; j<next_ptr[k+1]; ++j) sum += chance[j];
+            for(int j=next_ptr[k]; j<next_ptr[k+1]; ++j) file_tree.values.push_back(chance[j] / sum);
+            infosets[k] = 0;
+        } else{
+            if(players[k] < 0 || players[k] > player_num) throw std::invalid_argument("player of node " + std::to_string(k) + " out of range {0, ..., "+std::to_string(player_num)+"}");
+            if(infosets[k] < 1) throw std::invalid_argument("Infoset index should start from 1, node idx: " + std::to_string(k) + " does not satisfy it");
+            infoset_num[players[k]] = std::max(infoset_num[players[k]], infosets[k]);
+        }
+        file_tree.value_ptr.push_back(file_tree.values.size());
+    }
+    for(auto& child : next)
+        if(child < 0 || child >= node_num) throw std::invalid_argument("child index " + std::to_string(child) + " out of range {0, ..., " + std::to_string(node_num-1) + "}");
+
+    for(int player=1; player<=player_num; ++player){
+        infoset_names_backup[player].resize(infoset_num[player]);
+        if(infoset_names_.size() == 0) continue;
+        for(int i=0; i<infoset_num[player] && i<infoset_names_[player-1].size(); ++i)
+            infoset_names_backup[player][i] = infoset_names_[player-1][i];
+    }
+    file_tree.players = std::move(players);
+    file_tree.infosets = std::move(infosets);
+    file_tree.next_ptr = std::move(next_ptr);
+    file_tree.next = std::move(next);
+
+    BuildNodes();
+    file_tree = FileTree();
+    RenumberInfosets();
+}
+
+void FileEnvironment::RenumberInfosets(){
+    /*
+        Renumber the infosets of each player in the order of their first appearance in nodes
+        Names are copied only now, after all per-node data except the game tree are released
+    */
+    std::vector<std::vector<int>> infoset_order(player_num+1);
+    for(int i=0; i<=player_num; ++i){
+        infoset_order[i].assign(infoset_num[i]+1, 0);
+        infoset_num[i] = 0;
+    }
     for(int i=0; i<nodes.size(); ++i) if(nodes[i]->player != 0){
-        auto it = infoset_map.find(std::make_pair(nodes[i]->player, nodes[i]->infoset));
-        if(it == infoset_map.end()){
-            infoset_map[std::make_pair(nodes[i]->player, nodes[i]->infoset)] = ++infoset_num[nodes[i]->player];
-            it = infoset_map.find(std::make_pair(nodes[i]->player, nodes[i]->infoset));
-            infoset_names[nodes[i]->player].push_back(infoset_names_backup[nodes[i]->player][nodes[i]->infoset-1]);
+        int player = nodes[i]->player, infoset = nodes[i]->infoset;
+        if(infoset_order[player][infoset] == 0){
+            infoset_order[player][infoset] = ++infoset_num[player];
+            if(Is_Keep_Infoset_Names){
+                std::string_view backup_name = infoset_names_backup[player][infoset-1];
+                if(backup_name.empty()) infoset_names[player].push_back("pl"+std::to_string(player)+"_"+std::to_string(infoset)+"__singleton");
+                else infoset_names[player].push_back(backup_name);
+            }
+        }
+        nodes[i]->infoset = infoset_order[player][infoset];
+    }
+    for(auto& names : infoset_names) names.shrink_to_fit();
+    infoset_names_backup = std::vector<std::vector<std::string_view>>();
+}
+
+static void WriteArray(std::ofstream& out, const void* data, const size_t& bytes){
+    // Arrays are padded to 8 bytes so that every array in the mapped file is aligned
+    static const char padding[8] = {0};
+    out.write((const char*)data, bytes);
+    if(bytes % 8 != 0) out.write(padding, 8 - bytes % 8);
+}
+
+template <typename T>
+static const T* ReadArray(const char*& cursor, const char* file_end, const int64_t& size){
+    if(size < 0 || (size_t)size > (size_t)(file_end - cursor) / sizeof(T)) throw std::runtime_error("Binary game file is truncated");
+    size_t bytes = sizeof(T) * size;
+    const T* ret = (const T*)cursor;
+    cursor += std::min((bytes + 7) / 8 * 8, (size_t)(file_end - cursor));
+    return ret;
+}
+
+void FileEnvironment::SaveBinary(const std::string& file_name){
+    /*
+        Write the game tree in the binary format, which can be loaded by FileEnvironment(file_name, traverse)
+        The tree is stored in the order of nodes, i.e. parent always before children
+    */
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    int offset = Flags_Initialized ? 1 : 0; // skip the virtual root added by Node::Preprocessing
+    int64_t node_num = nodes.size() - offset;
+
+    std::vector<int32_t> player(node_num), infoset(node_num), children;
+    std::vector<int64_t> child_ptr(node_num+1, 0), chance_ptr(node_num+1, 0), name_ptr(1, 0);
+    std::vector<double> chance, payoff;
+    std::vector<int64_t> infoset_count(player_num+1, 0);
+    std::string names;
+
+    for(int64_t i=0; i<node_num; ++i){
+        Node* node = nodes[i+offset];
+        player[i] = node->player;
+        infoset[i] = node->infoset;
+        for(auto& next : node->next_node) children.push_back(next - offset);
+        child_ptr[i+1] = children.size();
+        if(node->player == 0){
+            for(int j=0; j<node->chance.size; ++j) chance.push_back(node->chance[j]);
+        }
+        chance_ptr[i+1] = chance.size();
+        if(node->next_node.size() == 0){
+            for(int p=1; p<=player_num; ++p) payoff.push_back(node->GetUtility(p));
+        } else if(node->player > 0){
+            infoset_count[node->player] = std::max<int64_t>(infoset_count[node->player], node->infoset);
+        }
+    }
+    for(int p=1; p<=player_num; ++p){
+        infoset_count[p] = std::max<int64_t>(infoset_count[p], infoset_names[p].size());
+        for(int i=0; i<infoset_count[p]; ++i){
+            if(i < infoset_names[p].size()) names += infoset_names[p].View(i); // unnamed infosets are saved as empty names, and load as unnamed
+            name_ptr.push_back(names.size());
         }
-        nodes[i]->infoset = it -> second;
+    }
+
+    BinaryGameHeader header;
+    memcpy(header.magic, binary_magic, 8);
+    header.version = binary_version;
+    header.byte_order = 0x01020304;
+    header.player_num = player_num;
+    header.node_num = node_num;
+    header.num_children = children.size();
+    header.num_chance = chance.size();
+    header.num_leaves = (player_num > 0) ? payoff.size() / player_num : 0;
+    header.num_names = name_ptr.size() - 1;
+    header.name_bytes = names.size();
+
+    std::ofstream out(file_name, std::ios::binary);
+    if(!out) throw std::runtime_error("Cannot open file " + file_name);
+    WriteArray(out, &header, sizeof(header));
+    WriteArray(out, player.data(), sizeof(int32_t) * player.size());
+    WriteArray(out, infoset.data(), sizeof(int32_t) * infoset.size());
+    WriteArray(out, child_ptr.data(), sizeof(int64_t) * child_ptr.size());
+    WriteArray(out, children.data(), sizeof(int32_t) * children.size());
+    WriteArray(out, chance_ptr.data(), sizeof(int64_t) * chance_ptr.size());
+    WriteArray(out, chance.data(), sizeof(double) * chance.size());
+    WriteArray(out, payoff.data(), sizeof(double) * payoff.size());
+    WriteArray(out, infoset_count.data(), sizeof(int64_t) * infoset_count.size());
+    WriteArray(out, name_ptr.data(), sizeof(int64_t) * name_ptr.size());
+    WriteArray(out, names.data(), names.size());
+    if(!out) throw std::runtime_error("Failed to write file " + file_name);
+}
+
+void FileEnvironment::LoadBinary(){
+    /*
+        Load the game tree written by SaveBinary from the memory-mapped file
+    */
+    const char *cursor = file_reader.data, *file_end = file_reader.data + file_reader.file_size;
+    const BinaryGameHeader& header = *ReadArray<BinaryGameHeader>(cursor, file_end, 1);
+    if(header.byte_order != 0x01020304) throw std::runtime_error("Binary game file is written by a machine with different endianness");
+    if(header.version != binary_version)
+        throw std::runtime_error("Unsupported binary game file version " + std::to_string(header.version) + ", expected " + std::to_string(binary_version));
+
+    if(header.player_num < 1 || header.node_num < 1 || header.node_num > INT32_MAX || header.num_children < 0 || header.num_chance < 0
+       || header.num_leaves < 0 || header.num_leaves > header.node_num || header.num_names < 0 || header.name_bytes < 0)
+        throw std::runtime_error("Binary game file is corrupted: invalid sizes in the header");
+    player_num = header.player_num;
+    node_num = header.node_num;
+    const int32_t* player = ReadArray<int32_t>(cursor, file_end, header.node_num);
+    const int32_t* infoset = ReadArray<int32_t>(cursor, file_end, header.node_num);
+    const int64_t* child_ptr = ReadArray<int64_t>(cursor, file_end, header.node_num+1);
+    const int32_t* children = ReadArray<int32_t>(cursor, file_end, header.num_children);
+    const int64_t* chance_ptr = ReadArray<int64_t>(cursor, file_end, header.node_num+1);
+    const double* chance = ReadArray<double>(cursor, file_end, header.num_chance);
+    const double* payoff = ReadArray<double>(cursor, file_end, header.num_leaves * header.player_num);
+    const int64_t* infoset_count = ReadArray<int64_t>(cursor, file_end, header.player_num+1);
+    const int64_t* name_ptr = ReadArray<int64_t>(cursor, file_end, header.num_names+1);
+    const char* names = ReadArray<char>(cursor, file_end, header.name_bytes);
+
+    /*
+        The arrays are checked before use, so a corrupted file throws instead of reading out of the mapped file
+    */
+    if(child_ptr[0] != 0 || child_ptr[node_num] != header.num_children || chance_ptr[0] != 0 || chance_ptr[node_num] != header.num_chance)
+        throw std::runtime_error("Binary game file is corrupted: invalid offsets of children");
+    for(int p=1; p<=player_num; ++p)
+        if(infoset_count[p] < 0 || infoset_count[p] > INT32_MAX) throw std::runtime_error("Binary game file is corrupted: invalid number of infosets");
+    int64_t num_leaves = 0;
+    for(int64_t i=0; i<node_num; ++i){
+        if(child_ptr[i] > child_ptr[i+1] || chance_ptr[i] > chance_ptr[i+1])
+            throw std::runtime_error("Binary game file is corrupted: invalid offsets of children");
+        if(player[i] < 0 || player[i] > player_num)
+            throw std::runtime_error("Binary game file is corrupted: player of node " + std::to_string(i) + " out of range {0, ..., "+std::to_string(player_num)+"}");
+        bool is_leaf = child_ptr[i] == child_ptr[i+1];
+        if(!is_leaf && player[i] > 0 && (infoset[i] < 1 || infoset[i] > infoset_count[player[i]]))
+            throw std::runtime_error("Binary game file is corrupted: infoset of node " + std::to_string(i) + " out of range {1, ..., "+std::to_string(infoset_count[player[i]])+"}");
+        int64_t chance_num = (!is_leaf && player[i] == 0) ? child_ptr[i+1] - child_ptr[i] : 0;
+        if(chance_ptr[i+1] - chance_ptr[i] != chance_num)
+            throw std::runtime_error("Binary game file is corrupted: chance probabilities do not match the children of node " + std::to_string(i));
+        num_leaves += is_leaf;
+    }
+    if(num_leaves != header.num_leaves) throw std::runtime_error("Binary game file is corrupted: number of leaves does not match the payoffs");
+
+    file_nodes.reserve(node_num);
+    nodes.reserve(node_num);
+    for(int64_t i=0, leaf=0; i<node_num; ++i){
+        file_nodes.push_back(FileNode(player[i], infoset[i], player_num));
+        FileNode& node = file_nodes.back();
+        node.next_node.assign(children + child_ptr[i], children + child_ptr[i+1]);
+        for(auto& next : node.next_node)
+            if(next <= i || next >= node_num) throw std::runtime_error("Binary game file is corrupted: children should be stored after their parent");
+        for(int64_t j=chance_ptr[i]; j<chance_ptr[i+1]; ++j) node.chance.push_back(chance[j]);
+        if(node.next_node.size() == 0){
+            for(int p=1; p<=player_num; ++p) node.utility[p] = payoff[leaf * player_num + p-1];
+            ++leaf;
+        }
+        nodes.push_back(&node);
+    }
+
+    infoset_names.resize(player_num+1);
+    infoset_num = std::vector<int>(player_num+1, 0);
+    for(int p=1, k=0; p<=player_num; ++p){
+        infoset_num[p] = infoset_count[p];
+        if(infoset_count[p] < 0 || k + infoset_count[p] > header.num_names)
+            throw std::runtime_error("Binary game file is corrupted: infoset names do not match the number of infosets");
+        for(int i=0; i<infoset_count[p]; ++i)
+            if(name_ptr[k+i] < 0 || name_ptr[k+i] > name_ptr[k+i+1] || name_ptr[k+i+1] > header.name_bytes)
+                throw std::runtime_error("Binary game file is corrupted: invalid offsets of infoset names");
+        // an empty name is an unnamed infoset of InfosetNames, so the index default of GetInfosetNames survives a round trip
+        infoset_names[p].chars.assign(names + name_ptr[k], names + name_ptr[k+infoset_count[p]]);
+        infoset_names[p].offsets.resize(infoset_count[p]+1);
+        for(int i=0; i<=infoset_count[p]; ++i)
+            infoset_names[p].offsets[i] = name_ptr[k+i] - name_ptr[k];
+        k += infoset_count[p];
     }
 }
@@ -5,35 +5,81 @@
 
 #include "Basic/FileReader.h"
 
+#include <cstdint>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <unordered_map>
-#include <map>
 
 class FileNode : public Node {
 public:
     std::vector<double> utility;
-    std::vector<std::string> actions;
-    std::string name;
-    bool is_root;
 
     FileNode(const int& player_, const int& infoset_, const int& player_num_);
     double GetUtility(const int& player) override;
 };
 
+class BinaryGameHeader {
+public:
+    char magic[8];
+    uint32_t version, byte_order; // byte_order is written as 0x01020304 to detect files from machines with another endianness
+    int64_t player_num, node_num, num_children, num_chance, num_leaves, num_names, name_bytes;
+};
+
+class FileTree {
+public:
+    /*
+        Nodes and infosets parsed from the game file (or a line-aligned chunk of it), stored in flat arrays instead of one object per node
+        Strings are views of the memory-mapped game file
+        Node i has actions actions[action_ptr[i]], ..., actions[action_ptr[i+1]-1],
+            and values[value_ptr[i]], ..., values[value_ptr[i+1]-1] are its chance probabilities (chance node) or payoffs of player 1, ..., n (leaf)
+        Infoset i contains the nodes infoset_nodes[infoset_ptr[i]], ..., infoset_nodes[infoset_ptr[i+1]-1]
+        After linking, children of node i are next[next_ptr[i]], ..., next[next_ptr[i+1]-1]
+    */
+    std::vector<std::string_view> names, actions;
+    std::vector<int> players, infosets, action_ptr{0}, value_ptr{0};
+    std::vector<double> values;
+
+    std::vector<std::string_view> infoset_names, infoset_nodes;
+    std::vector<int> infoset_ptr{0}, infoset_node_idx;
+
+    std::vector<int> next_ptr, next;
+
+    void Append(FileTree& chunk);
+};
+
 class FileEnvironment : public Environment {
 public:
     FileReader file_reader;
+    FileTree file_tree; // released after the game is built
     std::vector<FileNode> file_nodes;
-    std::vector<std::vector<std::string>> infoset_names_backup;
+    std::vector<std::vector<std::string_view>> infoset_names_backup; // empty name for singleton infosets not listed in the file
 
-    int node_num;
-    std::unordered_map<std::string, int> node_map;
-    std::map<std::pair<int, int>, int> infoset_map;
+    int node_num, num_threads;
+    bool Is_Keep_Infoset_Names;
+    std::vector<std::unordered_map<std::string_view, int>> node_map; // partitioned by the hash of node names, so that it is built in parallel
     std::vector<int> infoset_num;
 
-    FileEnvironment(const std::string& file_name_, const std::string& traverse_);
+    /*
+        Binary game format: a header followed by the preprocessed tree stored as flat arrays (8-byte aligned),
+        so that loading is a few memcpy over the memory-mapped file without parsing or string hashing
+        Files starting with binary_magic are recognized by the constructor automatically
+    */
+    static constexpr char binary_magic[9] = "LiteEFGb";
+    static const unsigned int binary_version = 1;
+
+    FileEnvironment(const std::string& file_name_, const std::string& traverse_, const int& num_threads_=0, const bool& keep_infoset_names=true);
+    void ParseChunk(FileCursor reader, FileTree& chunk);
+    void BuildNodeMap();
+    int FindNode(const std::string_view& name);
+    FileEnvironment(const int& player_num_, std::vector<int> players, std::vector<int> infosets, std::vector<int> next_ptr, std::vector<int> next,
+                    const std::vector<double>& chance, const std::vector<double>& payoffs, const std::vector<std::vector<std::string>>& infoset_names_,
+                    const std::string& traverse_);
     void GetNextNode(const bool& is_openspiel);
+    void BuildNodes();
+    void RenumberInfosets();
+    void LoadBinary();
+    void SaveBinary(const std::string& file_name);
 };
 
 #endif
\ No newline at end of file
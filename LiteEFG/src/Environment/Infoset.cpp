@@ -220,4 +220,23 @@ Vector Infoset::GetResult(const int& opIndex) {
         throw std::runtime_error("GetResult cannot acceed the results length");
     }
     return results[opIndex][0];
-}
\ No newline at end of file
+}
+std::string InfosetNames::operator[](const size_t& idx) const{
+    if(!IsNamed(idx)) return std::to_string(idx);
+    return std::string(View(idx));
+}
+
+void InfosetNames::push_back(const std::string_view& name){
+    chars.insert(chars.end(), name.begin(), name.end());
+    offsets.push_back(chars.size());
+}
+
+void InfosetNames::resize(const size_t& size){
+    offsets.resize(size+1, offsets.back());
+    chars.resize(offsets.back());
+}
+
+void InfosetNames::shrink_to_fit(){
+    chars.shrink_to_fit();
+    offsets.shrink_to_fit();
+}
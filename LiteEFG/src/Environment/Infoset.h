@@ -6,8 +6,10 @@
 #include "Computation/Graph.h"
 #include "Computation/GraphNode.h"
 
+#include <cstdint>
 #include <vector>
 #include <string>
+#include <string_view>
 
 class Node{
 public:
@@ -21,7 +23,7 @@ public:
 
     Vector reach; // Reach probability of each player
     Vector chance; // Chance probability if this is a chance node
-    bool is_terminal;
+    bool is_terminal = false;
 
     Node(const int& player_, const int& infoset_, const int& player_num_);
     
@@ -34,7 +36,7 @@ public:
     /*
         graph: computation graph given by the user
     */
-    Graph graph;
+    Graph graph{false};
     std::vector<std::vector<int>> children; // children infoset of each sequence (infoset, action)
     std::pair<int, int> parent; // parent sequence (infoset, action) of each infoset
     std::vector<std::vector<std::pair<int, int>>> parent_sequences; // parent sequence of each player
@@ -59,4 +61,24 @@ public:
     Vector GetResult(const int& opIndex);
 }; // Idx 0 is the root infoset
 
+class InfosetNames{
+public:
+    /*
+        Names of the infosets of a player, interned in one character buffer instead of one std::string per infoset
+        Name of the idx-th infoset (infoset idx+1) is chars[offsets[idx]:offsets[idx+1]]
+        Unnamed infosets take no space, and their names are generated from their indices when requested
+    */
+    std::vector<char> chars;
+    std::vector<int64_t> offsets{0};
+
+    size_t size() const { return offsets.size() - 1; }
+    bool IsNamed(const size_t& idx) const { return offsets[idx+1] > offsets[idx]; }
+    std::string_view View(const size_t& idx) const { return std::string_view(chars.data() + offsets[idx], offsets[idx+1] - offsets[idx]); }
+    std::string operator[](const size_t& idx) const;
+
+    void push_back(const std::string_view& name);
+    void resize(const size_t& size); // infosets appended are unnamed
+    void shrink_to_fit();
+};
+
 #endif
\ No newline at end of file
@@ -1,5 +1,10 @@
 #include "Environment/NFG/NFG.h"
 
+#include "Basic/BasicFunction.h"
+
+#include <stdexcept>
+#include <string>
+
 NFGNode::NFGNode(const int& player_, const int& infoset_, const int& player_num_) : Node(player_, infoset_, player_num_) {
     actions.clear();
     utility = std::vector<double>(player_num+1, 0.0);
@@ -12,41 +17,228 @@ double NFGNode::GetUtility(const int& player){
 NFG::NFG(const int& player_num_, const std::vector<Tensor>& utility_matrices_, const std::string& traverse_)
         : Environment(player_num_, traverse_){
 
+    if(player_num < 1) throw std::invalid_argument("the game should have at least 1 player");
+    if(utility_matrices_.size() != player_num)
+        throw std::invalid_argument("utility_matrices should contain one utility tensor per player");
+    for(auto& utility_matrix : utility_matrices_){
+        if(utility_matrix.dim != player_num || utility_matrix.shape.size() != player_num)
+            throw std::invalid_argument("the utility tensor of each player should have player_num dimensions");
+        if(utility_matrix.shape != utility_matrices_[0].shape)
+            throw std::invalid_argument("the utility tensors of all players should have the same shape");
+        size_t size = 1;
+        for(int num_actions : utility_matrix.shape){
+            if(num_actions < 1) throw std::invalid_argument("each player should have at least 1 action");
+            size *= num_actions;
+        }
+        if(utility_matrix.data.size() != size)
+            throw std::invalid_argument("the size of the utility tensor does not match its shape");
+    }
     utility_matrices = utility_matrices_;
+}
 
-    nfg_nodes.push_back(NFGNode(1, 1, player_num));
-
-    for(int i=0; i<nfg_nodes.size(); ++i){
-        if(nfg_nodes[i].actions.size() == player_num) continue; // terminal node
-        int player = nfg_nodes[i].player;
-        for(int a=0; a<utility_matrices[0].shape[player-1]; ++a){
-            nfg_nodes.push_back((player==player_num) ? NFGNode(1, 2, player_num) : NFGNode(player+1, 1, player_num));
-            int idx = nfg_nodes.size()-1;
-            nfg_nodes[idx].actions = nfg_nodes[i].actions;
-            nfg_nodes[idx].actions.push_back(a);
-            
-            nfg_nodes[i].next_node.push_back(idx);
-
-            if(player == player_num){
-                for(int p=1;p<=player_num;++p){
-                    nfg_nodes[idx].utility[p] = utility_matrices[p-1][nfg_nodes[idx].actions];
-                }
-                /*for(int p=2; p<=player_num; ++p){
-                    nfg_nodes.push_back(NFGNode(p, nfg_nodes[idx].actions[p-1]+2, player_num));
-                    nfg_nodes[nfg_nodes.size()-1].actions = nfg_nodes[idx].actions;
-                    nfg_nodes[idx].next_node.push_back(nfg_nodes.size()-1);
-                    idx = nfg_nodes.size()-1;
-                    nfg_nodes[idx].utility = utility_matrices[p-1][nfg_nodes[idx].actions];
-                }*/
+void NFG::Initialize(){
+    /*
+        Player p has the root infoset and infoset 1 with utility_matrices[0].shape[p-1] actions
+        Parent sequences are the same as in the game tree where players act in the order 1, ..., n, i.e. infoset 1 of player p
+        follows every sequence of the players before p
+    */
+    infoset_names.assign(player_num+1, InfosetNames());
+    infosets.clear();
+    for(int i=0;i<=player_num;i++){
+        infosets.push_back(std::vector<Infoset>());
+        infosets[i].push_back(Infoset());
+        infosets[i][0].reach = 1.0; // root infoset
+        infosets[i][0].children.push_back(std::vector<int>());
+        infosets[i][0].parent_sequences.resize(player_num+1);
+    }
+
+    decision_nodes.clear();
+    for(int player=1; player<=player_num; player++){
+        infosets[player].push_back(Infoset());
+        Infoset& infoset = infosets[player].back();
+        infoset.player = player;
+        infoset.children.resize(utility_matrices[0].shape[player-1]);
+        infoset.parent_sequences.resize(player_num+1);
+        for(int q=1; q<player; ++q)
+            for(int action=0; action<utility_matrices[0].shape[q-1]; ++action)
+                infoset.parent_sequences[q].push_back(std::make_pair(1, action));
+        infoset_names[player].resize(1); // named by its index
+
+        decision_nodes.push_back(NFGNode(player, 1, player_num));
+        decision_nodes.back().reach = Vector(player_num+1, 1.0);
+        decision_nodes.back().is_terminal = false;
+    }
+    InitializeInfosets();
+}
+
+void NFG::Contract(const std::vector<const double*>& strategies, const std::vector<double*>& values, const std::vector<double*>& compensations){
+    /*
+        For each player p with values[p] != NULL, values[p][a] += sum of utility_matrices[p-1][a_1, ..., a_n] * prod_{q != p} strategies[q][a_q]
+        over the joint actions with a_p = a. With compensations[p] != NULL, every term is added by Neumaier summation
+        The axis of player n is contiguous in the tensors, so the loops over it are the innermost ones
+    */
+    const std::vector<int>& shape = utility_matrices[0].shape;
+    int inner = shape[player_num-1];
+    size_t outer = utility_matrices[0].data.size() / inner;
+    const double* last = strategies[player_num];
+
+    std::vector<int> actions(player_num, 0); // actions[q] is the action of player q < n
+    std::vector<double> prefix(player_num+1, 1.0), suffix(player_num+1, 1.0); // products of strategies[q][actions[q]] over q in [1, i] and [i, n-1]
+    for(size_t k=0; k<outer; ++k){
+        for(int q=1; q<player_num; ++q) prefix[q] = prefix[q-1] * strategies[q][actions[q]];
+        for(int q=player_num-1; q>=1; --q) suffix[q] = suffix[q+1] * strategies[q][actions[q]];
+        size_t offset = k * inner;
+
+        for(int p=1; p<player_num; ++p) if(values[p] != NULL){
+            double weight = prefix[p-1] * suffix[p+1];
+            if(weight == 0.0) continue;
+            const double* utility = &utility_matrices[p-1].data[offset];
+            double& value = values[p][actions[p]];
+            if(compensations[p] != NULL){
+                double& compensation = compensations[p][actions[p]];
+                for(int a=0; a<inner; ++a) Basic::NeumaierAdd(value, compensation, utility[a] * (weight * last[a]));
+            } else{
+                double sum = 0.0;
+                for(int a=0; a<inner; ++a) sum += utility[a] * last[a];
+                value += weight * sum;
+            }
+        }
+        if(values[player_num] != NULL && prefix[player_num-1] != 0.0){
+            double weight = prefix[player_num-1];
+            const double* utility = &utility_matrices[player_num-1].data[offset];
+            double* value = values[player_num];
+            if(compensations[player_num] != NULL){
+                double* compensation = compensations[player_num];
+                for(int a=0; a<inner; ++a) Basic::NeumaierAdd(value[a], compensation[a], utility[a] * weight);
+            } else{
+                for(int a=0; a<inner; ++a) value[a] += utility[a] * weight;
             }
         }
+
+        for(int q=player_num-1; q>=1; --q){
+            if(++actions[q] < shape[q-1]) break;
+            actions[q] = 0;
+        }
+    }
+}
+
+void NFG::AddTraverseNode(const std::vector<int>& actions, const Vector& reach){
+    /*
+        Node after players 1, ..., actions.size() have played actions, which is terminal if all players have played
+    */
+    bool is_terminal = (actions.size() == player_num);
+    traverse_nodes.emplace_back(is_terminal ? 0 : (int)actions.size() + 1, is_terminal ? 0 : 1, player_num); // references to the nodes in a deque stay valid
+    NFGNode& node = traverse_nodes.back();
+    node.idx = traverse_nodes.size() - 1;
+    node.is_terminal = is_terminal;
+    node.actions = actions;
+    node.reach = reach;
+    for(int q=1; q<=actions.size(); ++q) node.parent_infoset[q] = std::make_pair(1, actions[q-1]);
+    if(is_terminal)
+        for(int p=1; p<=player_num; ++p) node.utility[p] = utility_matrices[p-1][actions];
+    traverse_order.push_back(&node);
+}
+
+void NFG::GetTraverseOrder(const int& current_traverse, const std::vector<GraphNode>& strategy_nodes, const int& traverser){
+    /*
+        Enumerate only visits the decision node of each player, the utilities are computed by AccumulateUtility from the strategies
+        Outcome and External sample the joint actions as Environment::GetTraverseOrder does on the game tree
+    */
+    traverse_order.clear();
+    traverse_nodes.clear();
+    contract_strategy_idx.clear();
+    if(current_traverse == Traverse::Enumerate){
+        contract_strategy_idx.resize(player_num+1, 0);
+        for(int player=1; player<=player_num; player++){
+            contract_strategy_idx[player] = strategy_nodes[player].idx;
+            traverse_order.push_back(&decision_nodes[player-1]);
+        }
+        return;
     }
 
-    for(int i=0; i<nfg_nodes.size(); ++i){
-        nodes.push_back(&nfg_nodes[i]);
+    AddTraverseNode(std::vector<int>(), Vector(player_num+1, 1.0));
+    for(int i=0; i<traverse_order.size(); i++){
+        NFGNode* node = static_cast<NFGNode*>(traverse_order[i]);
+        if(node -> is_terminal) continue;
+        int player = node -> player;
+
+        auto expand = [&](const int& action){
+            std::vector<int> actions = node -> actions;
+            actions.push_back(action);
+            Vector reach = node -> reach;
+            reach[player] *= GetProb(node, strategy_nodes[player].idx, action);
+            AddTraverseNode(actions, reach);
+        };
+        if(current_traverse == Traverse::External && player == traverser){
+            for(int action=0; action<utility_matrices[0].shape[player-1]; ++action) expand(action);
+        } else{
+            expand(Basic::Sample(GetProb(node, strategy_nodes[player].idx)));
+        }
     }
 }
 
-void NFG::Initialize(){
-    Environment::Initialize();
-}
\ No newline at end of file
+void NFG::AccumulateUtility(const int& upd_player){
+    /*
+        After Enumerate, the utility of each action of player p is the contraction of utility_matrices[p-1] with the strategies of the others,
+        and the opponent reach probability is the product of the total probability of the players before p
+    */
+    if(contract_strategy_idx.empty()){
+        Environment::AccumulateUtility(upd_player);
+        return;
+    }
+
+    std::vector<const double*> strategies(player_num+1, NULL);
+    std::vector<double*> values(player_num+1, NULL), compensations(player_num+1, NULL);
+    for(int player=1; player<=player_num; player++){
+        Vector& strategy = infosets[player][1].results[contract_strategy_idx[player]][0];
+        if(strategy.size != utility_matrices[0].shape[player-1]){
+            throw std::invalid_argument("action out of range, please check the strategy feed into env.Update()");
+        }
+        strategies[player] = strategy.data();
+        if(upd_player == -1 || upd_player == player)
+            values[player] = infosets[player][1].results[GraphNode::NodeIdx::utility][0].data();
+    }
+    Contract(strategies, values, compensations);
+
+    double opponent_reach = 1.0;
+    for(int player=1; player<=player_num; player++){
+        if(values[player] != NULL)
+            infosets[player][1].results[GraphNode::NodeIdx::opponent_reach_prob][0][0] = opponent_reach;
+        double total = 0.0;
+        for(int action=0; action<utility_matrices[0].shape[player-1]; ++action) total += strategies[player][action];
+        opponent_reach *= total;
+    }
+}
+
+void NFG::ComputeGradient(std::vector<SequenceForm>& sequence_forms){
+    std::vector<const double*> strategies(player_num+1, NULL);
+    std::vector<double*> values(player_num+1, NULL), compensations(player_num+1, NULL);
+    for(int player=1; player<=player_num; player++){
+        SequenceForm& sequence_form = sequence_forms[player];
+        int idx = sequence_form.GetIdx(1, 0);
+        strategies[player] = &sequence_form.strategy[idx];
+        values[player] = &sequence_form.gradient[idx];
+        if(Is_Compensated_Summation) compensations[player] = &sequence_form.gradient_compensation[idx];
+    }
+    Contract(strategies, values, compensations);
+}
+
+void NFG::WalkTerminals(const std::function<void(const double&, const std::vector<std::pair<int, int>>&, const double*)>& func){
+    /*
+        Joint actions in the order of the tensor entries
+    */
+    std::vector<std::pair<int, int>> parent_infoset(player_num+1, std::make_pair(0, 0));
+    std::vector<double> utility(player_num+1, 0.0);
+    std::vector<int> actions(player_num+1, 0);
+    for(size_t k=0; k<utility_matrices[0].data.size(); ++k){
+        for(int p=1; p<=player_num; ++p){
+            parent_infoset[p] = std::make_pair(1, actions[p]);
+            utility[p] = utility_matrices[p-1].data[k];
+        }
+        func(1.0, parent_infoset, utility.data());
+        for(int q=player_num; q>=1; --q){
+            if(++actions[q] < utility_matrices[0].shape[q-1]) break;
+            actions[q] = 0;
+        }
+    }
+}
@@ -6,13 +6,13 @@
 #include "Environment/Infoset.h"
 #include "Environment/Environment.h"
 
+#include <deque>
 #include <vector>
 
 class NFGNode : public Node{
 public:
     std::vector<int> actions;
     std::vector<double> utility;
-    bool is_terminal;
 
     NFGNode(const int& player_, const int& infoset_, const int& player_num_);
     double GetUtility(const int& player) override;
@@ -20,11 +20,26 @@ public:
 
 class NFG : public Environment{
 public:
+    /*
+        Normal-form game, utility_matrices[p-1][a_1, ..., a_n] is the utility of player p when player i plays a_i
+        No game tree over the joint actions is stored: each player has a single infoset, and the utility of its actions is the
+        contraction of its utility tensor with the strategies of the others
+        Enumerate updates, exploitability, and utility are contractions, sampled traversals create the nodes on the sampled joint actions
+    */
     std::vector<Tensor> utility_matrices;
-    std::vector<NFGNode> nfg_nodes;
+    std::vector<NFGNode> decision_nodes; // decision_nodes[p-1] is the only decision node of player p visited by Enumerate
+    std::deque<NFGNode> traverse_nodes; // nodes of the current sampled traversal
+    std::vector<int> contract_strategy_idx; // strategy node of each player in the last Enumerate traversal, empty after a sampled one
 
     NFG(const int& player_num_, const std::vector<Tensor>& utility_matrix, const std::string& traverse_="Enumerate");
-    void Initialize();
+    void Initialize() override;
+
+    void Contract(const std::vector<const double*>& strategies, const std::vector<double*>& values, const std::vector<double*>& compensations);
+    void AddTraverseNode(const std::vector<int>& actions, const Vector& reach);
+    void GetTraverseOrder(const int& current_traverse, const std::vector<GraphNode>& strategy_nodes, const int& traverser) override;
+    void AccumulateUtility(const int& upd_player) override;
+    void ComputeGradient(std::vector<SequenceForm>& sequence_forms) override;
+    void WalkTerminals(const std::function<void(const double&, const std::vector<std::pair<int, int>>&, const double*)>& func) override;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -38,9 +38,7 @@ class OpenSpielEnv(LiteEFG.FileEnv):
 
         game_name = game.get_type().short_name
         infosets = {}
-        observation_tensors = {}
         num_infosets = [0 for _ in range(game.num_players())]
-        queue = [game.new_initial_state()]
 
         game_full_name = game_name
         for k in game.get_parameters():
@@ -58,97 +56,89 @@ class OpenSpielEnv(LiteEFG.FileEnv):
             return
         
         print("Generating %s.openspiel instance from OpenSpiel"%(game_full_name))
-        file = open(file_name, "w")
 
-        print("# %s instance with parameters:"%game_name, file=file)
-        print("#", file=file)
-        print("# Opt {", file=file)
-        print("#     openspiel,", file=file)
-        for k in game.get_parameters():
-            print("#     %s: %s,"%(k, game.get_parameters()[k]), file=file)
-        if "players" not in game.get_parameters():
-            print("#     players: %d,"%game.num_players(), file=file)
-        print("# }", file=file)
-        print("#", file=file)
+        # The game tree is passed to C++ as flat arrays, where the children of node k are next[next_ptr[k]:next_ptr[k+1]]
+        # Nodes are indexed when created, so the children of each node have consecutive indices
+        # chance_by_node[k] is the probability to reach node k from its chance parent, reordered to next_node at the end
+        num_players = game.num_players()
+        players, infoset_idx, first_child, num_children, chance_by_node, payoffs = [0], [0], [0], [0], [0.0], [0.0] * num_players
+        infoset_names = [[] for _ in range(num_players)]
+        queue = [(game.new_initial_state(), 0)]
 
         while len(queue) > 0:
-            node = queue.pop()
-            
+            node, idx = queue.pop()
+
             if node.is_terminal():
-                print("node %s leaf payoffs"%NodeName(node), end='', file=file)
-                for player, reward in enumerate(node.returns()):
-                    print(" %d=%f"%(player+1, reward), end='', file=file)
-                print(file=file)
+                payoffs[idx * num_players:(idx + 1) * num_players] = node.returns()
                 continue
 
             if node.is_chance_node():
-                print("node %s chance actions"%NodeName(node), end='', file=file)
-                for action, prob in node.chance_outcomes():
-                    child = node.clone()
-                    child.apply_action(action)
-                    queue.append(child)
-                    print(" %s=%.8f"%(NodeName(child.serialize()), prob), end='', file=file)
-                print(file=file)
+                outcomes = node.chance_outcomes()
             else:
-                print("node %s player %d actions"%(NodeName(node), node.current_player()+1), end='', file=file)
-                for action in node.legal_actions():
-                    child = node.clone()
-                    child.apply_action(action)
-                    queue.append(child)
-                    print(" %s"%NodeName(child.serialize()), end='', file=file)
-                print(file=file)
-
+                outcomes = [(action, 0.0) for action in node.legal_actions()]
+            first_child[idx], num_children[idx] = len(players), len(outcomes)
+            for action, prob in outcomes:
+                child = node.clone()
+                child.apply_action(action)
+                queue.append((child, len(players)))
+                players.append(0)
+                infoset_idx.append(0)
+                first_child.append(0)
+                num_children.append(0)
+                chance_by_node.append(prob)
+                payoffs.extend([0.0] * num_players)
+
+            if not node.is_chance_node():
+                player = node.current_player()
+                players[idx] = player + 1
                 try:
                     infoset = node.information_state_string()
                 except:
                     raise ValueError("The game %s does not have information state implemented by OpenSpiel \
                                         (typically such games are also too large to run tabular algorithms)"%game_name)
                 if infoset not in infosets:
-                    observation_tensors[infoset] = node.observation_tensor()
-                    infosets[infoset] = [InfosetName(node, num_infosets[node.current_player()])]
-                    num_infosets[node.current_player()] += 1
-                infosets[infoset].append(node.serialize())
-
-        for infoset in infosets:
-            if kwargs.get("is_gym", False):
-                print("infoset %s nodes"%(f"{','.join(map(str, observation_tensors[infoset]))}"), end='', file=file)
-            else:
-                print("infoset %s nodes"%infosets[infoset][0], end='', file=file)
-            for node in infosets[infoset][1:]:
-                print(" %s"%NodeName(node), end='', file=file)
-            print(file=file)
-        
-        file.close()
-        super().__init__(file_name, traverse_type=traverse_type)
+                    if kwargs.get("is_gym", False):
+                        name = ','.join(map(str, node.observation_tensor()))
+                    else:
+                        name = InfosetName(node, num_infosets[player])
+                    num_infosets[player] += 1
+                    infosets[infoset] = num_infosets[player]
+                    infoset_names[player].append(name)
+                infoset_idx[idx] = infosets[infoset]
+
+        num_children = np.array(num_children, dtype=np.int32)
+        first_child = np.array(first_child, dtype=np.int32)
+        next_ptr = np.concatenate(([0], np.cumsum(num_children))).astype(np.int32)
+        next_node = np.repeat(first_child - next_ptr[:-1], num_children) + np.arange(next_ptr[-1], dtype=np.int32)
+        super().__init__(num_players, np.array(players, dtype=np.int32), np.array(infoset_idx, dtype=np.int32), next_ptr, next_node.astype(np.int32),
+                         np.array(chance_by_node, dtype=np.float64)[next_node], np.array(payoffs, dtype=np.float64), infoset_names, traverse_type=traverse_type)
+        self.save_binary(file_name) # cache the game, which is loaded by FileEnv(file_name) next time
     
+    def _policy_rows(self, player: int) -> np.ndarray:
+        # the row in TabularPolicy of each infoset of player, in the order of the infosets in LiteEFG
+        names = self.get_infoset_names(player)
+        return np.array([self.state_lookup[name[name.find('__')+2:]] for name in names], dtype=np.int64)
+
     def get_value(self, player: int, node: LiteEFG.GraphNode) -> typing.List[typing.Tuple[str, float]]:
-        values = super().get_value(player, node)
-        policy = TabularPolicy(self.game)
-        ret = []
-        for k, _ in values:
-            idx = self.state_lookup[k[k.find('__')+2:]]
-            infoset = list(policy.state_lookup.keys())[idx]
-            ret.append((infoset, _))
-        return ret
+        values, offsets = self.get_value_array(player, node)
+        state_names = list(TabularPolicy(self.game).state_lookup.keys())
+        rows = self._policy_rows(player)
+        return [(state_names[row], values[offsets[i]:offsets[i+1]].tolist()) for i, row in enumerate(rows)]
 
     def get_strategy(self, strategy_node: LiteEFG.GraphNode, type_name="default") -> typing.Tuple[TabularPolicy, typing.List[pd.DataFrame]]:
         df_list = []
         policy = TabularPolicy(self.game)
+        state_names = list(policy.state_lookup.keys())
 
         for player in range(self.game.num_players()):
-            #print("Player %d strategy"%player)
-            df = pd.DataFrame(columns=["Infoset"] + [self.game.action_to_string(player, _) for _ in range(self.game.num_distinct_actions())])
-            strategy = super().get_strategy(player+1, strategy_node, type_name)
-            data_list = []
-            for infoset, probs in strategy:
-                idx = self.state_lookup[infoset[infoset.find('__')+2:]]
-                policy.action_probability_array[idx][policy.legal_actions_mask[idx]>0.5] = probs
-                new_row = pd.DataFrame([[list(policy.state_lookup.keys())[idx]] + list(policy.action_probability_array[idx])], columns=df.columns)
-                data_list.append(new_row)
-            import warnings
-            with warnings.catch_warnings():
-                warnings.simplefilter(action='ignore', category=FutureWarning)
-                df = pd.concat([df]+data_list, ignore_index=True)
+            columns = [self.game.action_to_string(player, _) for _ in range(self.game.num_distinct_actions())]
+            rows = self._policy_rows(player+1)
+            strategy = super().get_flat_strategy(player+1, strategy_node, type_name)
+            probs = policy.action_probability_array[rows]
+            probs[policy.legal_actions_mask[rows] > 0.5] = strategy.values # legal actions of each infoset, in order
+            policy.action_probability_array[rows] = probs
+            df = pd.DataFrame(probs, columns=columns)
+            df.insert(0, "Infoset", [state_names[row] for row in rows])
             df_list.append(df)
         
         #from open_spiel.python.algorithms import exploitability
@@ -156,7 +146,7 @@ class OpenSpielEnv(LiteEFG.FileEnv):
         #print("Exploitability: %f"%expl)
         return policy, df_list
 
-    def set_value(self, player: int, node: LiteEFG.GraphNode, values: typing.List[typing.List]) -> None:
+    def set_value(self, player: int, node: LiteEFG.GraphNode, values: typing.Union[typing.List, np.ndarray]) -> None:
         super().set_value(player, node, values)
 
     def interact(self, policy: TabularPolicy, controlled_player=0, reveal_private=True, epochs=1000) -> None:
@@ -0,0 +1,349 @@
+#include "Environment/Poker/Poker.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+static const char rank_chars[] = "23456789TJQKA";
+static const char suit_chars[] = "shdc";
+
+Poker::Poker(const int& player_num_, const int& num_ranks_, const int& num_suits_, const int& hole_cards_,
+             const std::vector<int>& board_cards_, const std::vector<std::vector<int>>& raise_sizes_,
+             const std::vector<int>& max_raises_, const int& ante_, const bool& suit_isomorphism)
+            : GameDefinition(player_num_, 2 + player_num_ * (hole_cards_ + 2) + std::accumulate(board_cards_.begin(), board_cards_.end(), 0)),
+              num_ranks(num_ranks_), num_suits(num_suits_), hole_cards(hole_cards_), ante(ante_), num_cards(num_ranks_ * num_suits_),
+              board_cards(board_cards_), max_raises(max_raises_), raise_sizes(raise_sizes_), Is_Suit_Isomorphism(suit_isomorphism) {
+    if(player_num < 2 || player_num > 32) throw std::invalid_argument("num_players should be in {2, ..., 32}");
+    if(num_ranks < 1 || num_ranks > 13) throw std::invalid_argument("num_ranks should be in {1, ..., 13}");
+    if(num_suits < 1 || num_suits > 4) throw std::invalid_argument("num_suits should be in {1, ..., 4}");
+    if(hole_cards < 1) throw std::invalid_argument("hole_cards should be at least 1");
+    if(ante < 0) throw std::invalid_argument("ante should be non-negative");
+    if(board_cards.empty()) throw std::invalid_argument("there should be at least one betting round");
+    if(raise_sizes.size() != board_cards.size() || max_raises.size() != board_cards.size())
+        throw std::invalid_argument("board_cards, raise_sizes and max_raises should have one entry per betting round");
+    for(int round=0; round<board_cards.size(); round++){
+        if(board_cards[round] < 0) throw std::invalid_argument("board_cards should be non-negative");
+        if(max_raises[round] < 0) throw std::invalid_argument("max_raises should be non-negative");
+        for(auto& size : raise_sizes[round]) if(size <= 0) throw std::invalid_argument("raise_sizes should be positive");
+    }
+
+    cards_needed.push_back(player_num * hole_cards + board_cards[0]);
+    for(int round=1; round<board_cards.size(); round++) cards_needed.push_back(cards_needed.back() + board_cards[round]);
+    if(cards_needed.back() > num_cards)
+        throw std::invalid_argument(std::to_string(cards_needed.back()) + " cards are dealt, but the deck only has " + std::to_string(num_cards) + " cards");
+
+    BettingNode root;
+    root.round = 0;
+    root.player = 1;
+    root.pot = std::vector<int>(player_num, ante);
+    root.folded = 0;
+    AddBettingNode(root, 0, 0, 0);
+}
+
+int Poker::AddBettingNode(const BettingNode& node, const int& num_raises, const int& last_raiser, const uint32_t& acted){
+    /*
+        Build the betting subtree of node depth-first, acted is the set of players who acted since the last raise
+        A player can only fold when facing a bet, and cannot re-raise her own raise
+        The round ends when every player who has not folded acted since the last raise
+    */
+    int idx = betting_nodes.size();
+    betting_nodes.push_back(node);
+    if(node.player == 0) return idx;
+
+    int player = node.player, round = node.round, max_pot = *std::max_element(node.pot.begin(), node.pot.end());
+    uint32_t all_players = (player_num == 32) ? ~0u : ((1u << player_num) - 1), bit = 1u << (player - 1);
+    std::vector<int> actions;
+    if(node.pot[player-1] < max_pot) actions.push_back(0);
+    actions.push_back(1);
+    if(num_raises < max_raises[round] && last_raiser != player)
+        for(int k=0; k<raise_sizes[round].size(); k++) actions.push_back(2 + k);
+
+    for(auto& action : actions){
+        BettingNode child = node;
+        child.actions.clear();
+        child.children.clear();
+        int child_raises = num_raises, child_last_raiser = last_raiser;
+        uint32_t child_acted = acted | bit;
+        if(action == 0){
+            child.folded |= bit;
+            child.name += 'F';
+        } else if(action == 1){
+            child.pot[player-1] = max_pot;
+            child.name += 'C';
+        } else{
+            child.pot[player-1] = max_pot + raise_sizes[round][action-2];
+            child_raises++;
+            child_last_raiser = player;
+            child_acted = bit;
+            child.name += 'R';
+            if(raise_sizes[round].size() > 1) child.name += std::to_string(raise_sizes[round][action-2]);
+        }
+
+        int num_active = player_num - __builtin_popcount(child.folded);
+        if(num_active == 1){
+            child.player = 0;
+        } else if((child_acted | child.folded) == all_players){ // the round ends
+            if(round == board_cards.size()-1){
+                child.player = 0;
+            } else{
+                child.round++;
+                child.name += '|';
+                child_raises = child_last_raiser = 0;
+                child_acted = 0;
+                for(child.player=1; child.folded >> (child.player-1) & 1; child.player++);
+            }
+        } else{
+            child.player = player;
+            do child.player = child.player % player_num + 1; while(child.folded >> (child.player-1) & 1);
+        }
+
+        int child_idx = AddBettingNode(child, child_raises, child_last_raiser, child_acted);
+        betting_nodes[idx].actions.push_back(action);
+        betting_nodes[idx].children.push_back(child_idx);
+    }
+    return idx;
+}
+
+int Poker::GetDeals(const int64_t* state, int* deal_cards, int* deal_weights){
+    /*
+        Number of cards that can be dealt next, stored in deal_cards with weights proportional to their probabilities in deal_weights
+        Both arrays should have room for max_cards entries
+        With suit isomorphism, all the suits not dealt yet are interchangeable, so only the first of them is dealt
+    */
+    int num_dealt = state[1];
+    uint64_t dealt = 0;
+    uint32_t used_suits = 0;
+    for(int i=0; i<num_dealt; i++){
+        dealt |= 1ull << state[2+i];
+        used_suits |= 1u << (state[2+i] % num_suits);
+    }
+    int num_deals = 0;
+    for(int rank=0; rank<num_ranks; rank++){
+        int num_unused = 0, first_unused = -1;
+        for(int suit=0; suit<num_suits; suit++){
+            int card = rank * num_suits + suit;
+            if(Is_Suit_Isomorphism && !(used_suits >> suit & 1)){
+                if(num_unused++ == 0) first_unused = card;
+            } else if(!(dealt >> card & 1)){
+                deal_cards[num_deals] = card;
+                deal_weights[num_deals++] = 1;
+            }
+        }
+        if(num_unused > 0){
+            deal_cards[num_deals] = first_unused;
+            deal_weights[num_deals++] = num_unused;
+        }
+    }
+    return num_deals;
+}
+
+int Poker::GetView(const int& player, const int64_t* state, const int& num_dealt){
+    /*
+        Index of the cards seen by player: group 0 is her hole cards, and the following groups are the boards of each round
+        With suit isomorphism, the suits are sorted by the ranks they have in each group, so views equal up to
+        a permutation of suits have the same index
+    */
+    std::vector<std::pair<int, int>> groups(1, std::make_pair((player-1) * hole_cards, player * hole_cards)); // card positions [first, second)
+    for(int round=0; round<board_cards.size(); round++)
+        if(board_cards[round] > 0 && cards_needed[round] <= num_dealt)
+            groups.push_back(std::make_pair(cards_needed[round] - board_cards[round], cards_needed[round]));
+
+    int num_groups = groups.size();
+    std::vector<uint16_t> view_masks(num_suits * num_groups, 0); // view_masks[suit * num_groups + g]: ranks of suit in group g
+    for(int g=0; g<num_groups; g++)
+        for(int i=groups[g].first; i<groups[g].second; i++)
+            view_masks[state[2+i] % num_suits * num_groups + g] |= 1u << (state[2+i] / num_suits);
+
+    int order[4] = {0, 1, 2, 3}, position[4]; // position[suit]: index of suit in the canonical order
+    if(Is_Suit_Isomorphism)
+        std::stable_sort(order, order + num_suits, [&](const int& a, const int& b){
+            return std::lexicographical_compare(&view_masks[b * num_groups], &view_masks[(b+1) * num_groups],
+                                                &view_masks[a * num_groups], &view_masks[(a+1) * num_groups]);
+        });
+    std::string key;
+    for(int i=0; i<num_suits; i++){
+        position[order[i]] = i;
+        for(int g=0; g<num_groups; g++){
+            uint16_t mask = view_masks[order[i] * num_groups + g];
+            key += char(mask & 255), key += char(mask >> 8);
+        }
+    }
+
+    auto it = view_map.find(key);
+    if(it != view_map.end()) return it->second;
+
+    std::string name;
+    for(int g=0; g<num_groups; g++){
+        if(g > 0) name += '/';
+        std::vector<std::pair<int, int>> group_cards; // (rank, canonical suit)
+        for(int i=groups[g].first; i<groups[g].second; i++)
+            group_cards.push_back(std::make_pair(state[2+i] / num_suits, Is_Suit_Isomorphism ? position[state[2+i] % num_suits] : state[2+i] % num_suits));
+        std::sort(group_cards.begin(), group_cards.end(), [](const std::pair<int, int>& a, const std::pair<int, int>& b){
+            return a.first != b.first ? a.first > b.first : a.second < b.second;
+        });
+        for(auto& card : group_cards){
+            name += rank_chars[13 - num_ranks + card.first];
+            name += suit_chars[card.second];
+        }
+    }
+    view_map[key] = view_names.size();
+    view_names.push_back(name);
+    return view_names.size() - 1;
+}
+
+uint64_t Poker::Evaluate(const std::vector<int>& cards){
+    /*
+        Value of the best 5-card poker hand in cards (of all cards if there are fewer than 5), larger is better
+        The category is followed by the ranks of the 5 cards breaking ties, 4 bits each
+        Straights need 5 consecutive ranks, the ace does not play low
+    */
+    int count[13] = {0}, suit_count[4] = {0};
+    uint32_t rank_mask = 0, suit_mask[4] = {0};
+    for(auto& card : cards){
+        int rank = card / num_suits, suit = card % num_suits;
+        count[rank]++;
+        suit_count[suit]++;
+        rank_mask |= 1u << rank;
+        suit_mask[suit] |= 1u << rank;
+    }
+    auto straight = [](const uint32_t& mask){
+        for(int rank=12; rank>=4; rank--) if((mask >> (rank-4) & 31u) == 31u) return rank;
+        return -1;
+    };
+    auto top = [](const uint32_t& mask, int k, std::vector<int> ranks){ // append the k highest ranks in mask
+        for(int rank=12; rank>=0 && k>0 && ranks.size()<5; rank--) if(mask >> rank & 1){
+            ranks.push_back(rank);
+            k--;
+        }
+        return ranks;
+    };
+    auto pack = [](const int& category, const std::vector<int>& ranks){
+        uint64_t value = category;
+        for(int i=0; i<5; i++) value = (value << 4) | (i < ranks.size() ? ranks[i] + 1 : 0);
+        return value;
+    };
+
+    std::vector<int> groups[5]; // groups[c]: ranks appearing c times, in decreasing order
+    for(int rank=12; rank>=0; rank--) groups[std::min(count[rank], 4)].push_back(rank);
+
+    int straight_flush = -1;
+    for(int suit=0; suit<num_suits; suit++) if(suit_count[suit] >= 5) straight_flush = std::max(straight_flush, straight(suit_mask[suit]));
+    if(straight_flush >= 0) return pack(8, {straight_flush});
+    if(!groups[4].empty()){
+        int quads = groups[4][0];
+        return pack(7, top(rank_mask & ~(1u << quads), 1, {quads, quads, quads, quads}));
+    }
+    if(!groups[3].empty() && (groups[3].size() > 1 || !groups[2].empty())){
+        int trips = groups[3][0], pair = std::max(groups[3].size() > 1 ? groups[3][1] : -1, groups[2].empty() ? -1 : groups[2][0]);
+        return pack(6, {trips, trips, trips, pair, pair});
+    }
+    uint64_t flush = 0;
+    for(int suit=0; suit<num_suits; suit++) if(suit_count[suit] >= 5) flush = std::max(flush, pack(5, top(suit_mask[suit], 5, {})));
+    if(flush > 0) return flush;
+    int straight_rank = straight(rank_mask);
+    if(straight_rank >= 0) return pack(4, {straight_rank});
+    if(!groups[3].empty()){
+        int trips = groups[3][0];
+        return pack(3, top(rank_mask & ~(1u << trips), 2, {trips, trips, trips}));
+    }
+    if(groups[2].size() >= 2){
+        int high = groups[2][0], low = groups[2][1];
+        return pack(2, top(rank_mask & ~(1u << high) & ~(1u << low), 1, {high, high, low, low}));
+    }
+    if(groups[2].size() == 1){
+        int pair = groups[2][0];
+        return pack(1, top(rank_mask & ~(1u << pair), 3, {pair, pair}));
+    }
+    return pack(0, top(rank_mask, 5, {}));
+}
+
+void Poker::Root(int64_t* state){
+    std::fill(state, state + state_size, -1);
+    state[0] = 0; // root of the betting tree
+    state[1] = 0; // no card is dealt
+}
+
+void Poker::Child(const int64_t* state, const int& action, int64_t* child){
+    std::copy(state, state + state_size, child);
+    const BettingNode& node = betting_nodes[state[0]];
+    int num_dealt = state[1];
+    if(num_dealt < cards_needed[node.round]){
+        int deal_cards[max_cards], deal_weights[max_cards];
+        GetDeals(state, deal_cards, deal_weights);
+        child[2 + num_dealt] = deal_cards[action];
+        child[1] = ++num_dealt;
+        if(num_dealt == cards_needed[node.round]) // the views only change when the dealing of a round completes
+            for(int player=1; player<=player_num; player++)
+                child[2 + cards_needed.back() + player - 1] = GetView(player, child, num_dealt);
+        if(num_dealt == cards_needed.back()) // hands are evaluated once, instead of at every terminal node
+            for(int player=1; player<=player_num; player++){
+                std::vector<int> cards(child + 2 + (player-1) * hole_cards, child + 2 + player * hole_cards);
+                cards.insert(cards.end(), child + 2 + player_num * hole_cards, child + 2 + num_dealt);
+                child[2 + num_dealt + player_num + player - 1] = Evaluate(cards);
+            }
+    } else{
+        child[0] = node.children[action];
+    }
+}
+
+int Poker::ChildCount(const int64_t* state){
+    const BettingNode& node = betting_nodes[state[0]];
+    if(node.player == 0) return 0;
+    if(state[1] < cards_needed[node.round]){
+        int deal_cards[max_cards], deal_weights[max_cards];
+        return GetDeals(state, deal_cards, deal_weights);
+    }
+    return node.actions.size();
+}
+
+int Poker::Player(const int64_t* state){
+    const BettingNode& node = betting_nodes[state[0]];
+    if(state[1] < cards_needed[node.round]) return 0;
+    return node.player;
+}
+
+uint64_t Poker::InfosetKey(const int64_t* state){
+    int player = betting_nodes[state[0]].player;
+    return (uint64_t)state[2 + cards_needed.back() + player - 1] * betting_nodes.size() + state[0];
+}
+
+void Poker::ChanceProbs(const int64_t* state, double* probs){
+    int deal_cards[max_cards], deal_weights[max_cards];
+    int num_deals = GetDeals(state, deal_cards, deal_weights);
+    double num_left = num_cards - state[1];
+    for(int i=0; i<num_deals; i++) probs[i] = deal_weights[i] / num_left;
+}
+
+void Poker::Payoff(const int64_t* state, double* payoff){
+    /*
+        The pot is split evenly among the winners
+    */
+    const BettingNode& node = betting_nodes[state[0]];
+    const int64_t* value = state + 2 + cards_needed.back() + player_num; // value[p-1]: hand of player p
+    bool is_showdown = (player_num - __builtin_popcount(node.folded) > 1);
+    int64_t best = -1;
+    int num_winners = 0;
+    double pot = 0.0;
+    for(int player=1; player<=player_num; player++){
+        pot += node.pot[player-1];
+        if(node.folded >> (player-1) & 1) continue;
+        int64_t player_value = is_showdown ? value[player-1] : 0;
+        if(player_value > best) best = player_value, num_winners = 0;
+        if(player_value == best) num_winners++;
+    }
+    for(int player=1; player<=player_num; player++){
+        payoff[player-1] = -node.pot[player-1];
+        if(!(node.folded >> (player-1) & 1) && (!is_showdown || value[player-1] == best)) payoff[player-1] += pot / num_winners;
+    }
+}
+
+std::string Poker::InfosetName(const int64_t* state){
+    int player = betting_nodes[state[0]].player;
+    return view_names[state[2 + cards_needed.back() + player - 1]] + ":" + betting_nodes[state[0]].name;
+}
+
+PokerEnvironment::PokerEnvironment(const int& player_num_, const int& num_ranks_, const int& num_suits_, const int& hole_cards_,
+                                   const std::vector<int>& board_cards_, const std::vector<std::vector<int>>& raise_sizes_,
+                                   const std::vector<int>& max_raises_, const int& ante_, const bool& suit_isomorphism, const std::string& traverse_)
+                                  : ProceduralEnvironment(std::make_shared<Poker>(player_num_, num_ranks_, num_suits_, hole_cards_, board_cards_,
+                                                                                  raise_sizes_, max_raises_, ante_, suit_isomorphism), traverse_) {}
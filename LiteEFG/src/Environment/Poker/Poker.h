@@ -0,0 +1,78 @@
+#ifndef POKER_H_
+#define POKER_H_
+
+#include "Environment/ProceduralEnvironment/ProceduralEnvironment.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class BettingNode{
+public:
+    /*
+        A node of the public betting tree, which does not depend on the cards
+        player is the player to act, 0 if the game ends at this node
+        action 0 is fold, 1 is check / call, and 2+k raises by raise_sizes[round][k]
+    */
+    int round, player;
+    std::vector<int> pot; // chips put in the pot by each player
+    uint32_t folded; // bit p-1 is set if player p has folded
+    std::vector<int> actions, children;
+    std::string name;
+};
+
+class Poker : public GameDefinition{
+public:
+    /*
+        Limit poker with num_ranks * num_suits cards. Each player antes and gets hole_cards private cards,
+        then board_cards[r] public cards are dealt at the beginning of the betting round r
+        In round r, a raise puts raise_sizes[r][k] more chips than the current bet, with at most max_raises[r] raises per round
+        The player with the best 5-card poker hand among the hole cards and the board wins the pot, which is split on ties
+
+        State: betting node, number of cards dealt, the cards in the order of dealing (card = rank * num_suits + suit),
+        view of each player, and the value of the hand of each player once all cards are dealt
+        The view of a player (hole cards and board cards of each round) is interned as an integer, and the infoset key packs
+        the view and the betting node into one integer
+        With suit_isomorphism, views are equal up to a permutation of suits, and the chance nodes only deal one card
+        of all the suits not dealt yet, weighted by the number of such suits
+        The functions keep no buffers in the game, since training and a background evaluation may call them at the same time
+    */
+    static const int max_cards = 52;
+    int num_ranks, num_suits, hole_cards, ante, num_cards;
+    std::vector<int> board_cards, max_raises, cards_needed; // cards_needed[r]: number of cards dealt before the betting of round r
+    std::vector<std::vector<int>> raise_sizes;
+    bool Is_Suit_Isomorphism;
+
+    std::vector<BettingNode> betting_nodes;
+    std::unordered_map<std::string, int> view_map; // only extended by the walk of Initialize, and read afterwards
+    std::vector<std::string> view_names;
+
+    Poker(const int& player_num_=2, const int& num_ranks_=3, const int& num_suits_=2, const int& hole_cards_=1,
+          const std::vector<int>& board_cards_={0, 1}, const std::vector<std::vector<int>>& raise_sizes_={{1}, {2}},
+          const std::vector<int>& max_raises_={2, 2}, const int& ante_=1, const bool& suit_isomorphism=true);
+
+    int AddBettingNode(const BettingNode& node, const int& num_raises, const int& last_raiser, const uint32_t& acted);
+    int GetDeals(const int64_t* state, int* deal_cards, int* deal_weights);
+    int GetView(const int& player, const int64_t* state, const int& num_dealt);
+    uint64_t Evaluate(const std::vector<int>& cards);
+
+    void Root(int64_t* state) override;
+    void Child(const int64_t* state, const int& action, int64_t* child) override;
+    int ChildCount(const int64_t* state) override;
+    int Player(const int64_t* state) override;
+    uint64_t InfosetKey(const int64_t* state) override;
+    void ChanceProbs(const int64_t* state, double* probs) override;
+    void Payoff(const int64_t* state, double* payoff) override;
+    std::string InfosetName(const int64_t* state) override;
+};
+
+class PokerEnvironment : public ProceduralEnvironment{
+public:
+    PokerEnvironment(const int& player_num_=2, const int& num_ranks_=3, const int& num_suits_=2, const int& hole_cards_=1,
+                     const std::vector<int>& board_cards_={0, 1}, const std::vector<std::vector<int>>& raise_sizes_={{1}, {2}},
+                     const std::vector<int>& max_raises_={2, 2}, const int& ante_=1, const bool& suit_isomorphism=true,
+                     const std::string& traverse_="Enumerate");
+};
+
+#endif
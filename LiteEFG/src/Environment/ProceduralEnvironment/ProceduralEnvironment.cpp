@@ -0,0 +1,193 @@
+#include "Environment/ProceduralEnvironment/ProceduralEnvironment.h"
+
+#include "Basic/BasicFunction.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+ProceduralNode::ProceduralNode(const int& player_, const int& infoset_, const int& player_num_) : Node(player_, infoset_, player_num_) {}
+
+double ProceduralNode::GetUtility(const int& player){
+    if(utility.empty()) return 0.0; // non-terminal node
+    return utility[player];
+}
+
+ProceduralEnvironment::ProceduralEnvironment(std::shared_ptr<GameDefinition> game_, const std::string& traverse_)
+                                            : Environment(game_ == nullptr ? 0 : game_->player_num, traverse_), game(game_) {
+    if(game == nullptr) throw std::invalid_argument("game should not be None");
+    if(game->player_num < 1) throw std::invalid_argument("the game should have at least 1 player");
+    if(game->state_size < 1) throw std::invalid_argument("state_size should be at least 1");
+}
+
+void ProceduralEnvironment::Initialize(){
+    /*
+        Discover all infosets by one depth-first walk over the states, in which no node is stored
+        Infosets are numbered in the order of their first visit, so parents are numbered before their children
+    */
+    infoset_names.assign(player_num+1, InfosetNames());
+    infoset_map.assign(player_num+1, std::unordered_map<uint64_t, int>());
+    infosets.clear();
+    for(int i=0;i<=player_num;i++){
+        infosets.push_back(std::vector<Infoset>());
+        infosets[i].push_back(Infoset());
+        infosets[i][0].reach = 1.0; // root infoset
+        infosets[i][0].children.push_back(std::vector<int>());
+        infosets[i][0].parent_sequences.resize(player_num+1);
+    }
+
+    walk_parent_infoset.assign(player_num+1, std::make_pair(0, 0));
+    Walk(0, 1.0, nullptr);
+
+    for(int player=1; player<=player_num; player++){
+        for(auto& infoset : infosets[player])
+            for(auto& parent_sequence : infoset.parent_sequences){
+                std::sort(parent_sequence.begin(), parent_sequence.end());
+                parent_sequence.erase(std::unique(parent_sequence.begin(), parent_sequence.end()), parent_sequence.end());
+                parent_sequence.shrink_to_fit();
+            }
+        infoset_names[player].shrink_to_fit();
+    }
+    InitializeInfosets();
+}
+
+int ProceduralEnvironment::GetInfoset(const int& player, const int64_t* state, const int& num_actions, const std::vector<std::pair<int, int>>& parent_infoset){
+    /*
+        Index of the infoset containing state, new infosets are only added during Initialize
+    */
+    if(player < 0 || player > player_num)
+        throw std::invalid_argument("Player(state) returns " + std::to_string(player) + ", which is out of range {0, ..., " + std::to_string(player_num) + "}");
+    uint64_t key = game->InfosetKey(state);
+    auto it = infoset_map[player].find(key);
+    int idx;
+    if(it != infoset_map[player].end()){
+        idx = it->second;
+        if(infosets[player][idx].children.size() != num_actions)
+            throw std::invalid_argument("states in infoset " + std::to_string(key) + " of player " + std::to_string(player) + " have different numbers of actions");
+        if(Flags_Initialized) return idx;
+        if(infosets[player][idx].parent != parent_infoset[player])
+            throw std::invalid_argument("infoset " + std::to_string(key) + " of player " + std::to_string(player) + " has different parent sequences, the game should have perfect recall");
+    } else{
+        if(Flags_Initialized)
+            throw std::runtime_error("infoset " + std::to_string(key) + " of player " + std::to_string(player) + " is not found, the game definition should be deterministic");
+        idx = infosets[player].size();
+        infoset_map[player][key] = idx;
+        infosets[player].push_back(Infoset());
+        Infoset& infoset = infosets[player].back();
+        infoset.player = player;
+        infoset.parent = parent_infoset[player];
+        infoset.children.resize(num_actions);
+        infoset.parent_sequences.resize(player_num+1);
+        infoset_names[player].push_back(game->InfosetName(state));
+    }
+
+    Infoset& infoset = infosets[player][idx];
+    for(int j=1; j<=player_num; ++j){ // parent sequences of each player, as computed by Infoset::ComputeParentInfoset
+        if(parent_infoset[j].first == 0) continue;
+        auto& parent_sequences = infoset.parent_sequences[j];
+        if(parent_sequences.empty() || parent_sequences.back() != parent_infoset[j]) // duplicates are removed in Initialize
+            parent_sequences.push_back(parent_infoset[j]);
+    }
+    return idx;
+}
+
+void ProceduralEnvironment::Walk(const int& depth, const double& chance_reach,
+                                 const std::function<void(const double&, const std::vector<std::pair<int, int>>&, const double*)>& func){
+    /*
+        Visit the subtree of walk_states[depth], the state at depth is game->Root() when depth = 0
+        walk_states is only accessed by offsets, since deeper calls may reallocate it
+    */
+    size_t offset = (size_t)depth * game->state_size;
+    if(walk_states.size() < offset + 2 * game->state_size) walk_states.resize(offset + 2 * game->state_size);
+    if(depth == 0) game->Root(&walk_states[0]);
+
+    int num_actions = game->ChildCount(&walk_states[offset]);
+    if(num_actions == 0){
+        if(func){
+            walk_utility.assign(player_num+1, 0.0);
+            game->Payoff(&walk_states[offset], &walk_utility[1]);
+            func(chance_reach, walk_parent_infoset, walk_utility.data());
+        }
+        return;
+    }
+
+    int player = game->Player(&walk_states[offset]);
+    if(player == 0){
+        std::vector<double> probs(num_actions, 0.0);
+        game->ChanceProbs(&walk_states[offset], probs.data());
+        for(int action=0; action<num_actions; ++action){
+            game->Child(&walk_states[offset], action, &walk_states[offset + game->state_size]);
+            Walk(depth+1, chance_reach * probs[action], func);
+        }
+    } else{
+        int infoset = GetInfoset(player, &walk_states[offset], num_actions, walk_parent_infoset);
+        std::pair<int, int> parent = walk_parent_infoset[player];
+        for(int action=0; action<num_actions; ++action){
+            walk_parent_infoset[player] = std::make_pair(infoset, action);
+            game->Child(&walk_states[offset], action, &walk_states[offset + game->state_size]);
+            Walk(depth+1, chance_reach, func);
+        }
+        walk_parent_infoset[player] = parent;
+    }
+}
+
+void ProceduralEnvironment::WalkTerminals(const std::function<void(const double&, const std::vector<std::pair<int, int>>&, const double*)>& func){
+    walk_parent_infoset.assign(player_num+1, std::make_pair(0, 0));
+    Walk(0, 1.0, func);
+}
+
+void ProceduralEnvironment::AddTraverseNode(const int64_t* state, const std::vector<std::pair<int, int>>& parent_infoset, const Vector& reach){
+    traverse_nodes.emplace_back(0, 0, player_num); // references to the nodes in a deque stay valid
+    ProceduralNode& node = traverse_nodes.back();
+    node.idx = traverse_nodes.size() - 1;
+    node.state.assign(state, state + game->state_size);
+    node.parent_infoset = parent_infoset;
+    node.reach = reach;
+
+    int num_actions = game->ChildCount(state);
+    node.is_terminal = (num_actions == 0);
+    if(node.is_terminal){
+        node.utility.assign(player_num+1, 0.0);
+        game->Payoff(state, &node.utility[1]);
+    } else{
+        node.player = game->Player(state);
+        if(node.player == 0){
+            std::vector<double> probs(num_actions, 0.0);
+            game->ChanceProbs(state, probs.data());
+            node.chance = Vector(probs);
+        } else node.infoset = GetInfoset(node.player, state, num_actions, parent_infoset);
+    }
+    traverse_order.push_back(&node);
+}
+
+void ProceduralEnvironment::GetTraverseOrder(const int& current_traverse, const std::vector<GraphNode>& strategy_nodes, const int& traverser){
+    /*
+        Same traversals as Environment::GetTraverseOrder, with nodes created from the states on the fly
+    */
+    traverse_order.clear();
+    traverse_nodes.clear();
+    std::vector<int64_t> state(game->state_size), child(game->state_size);
+    game->Root(state.data());
+    AddTraverseNode(state.data(), std::vector<std::pair<int, int>>(player_num+1, std::make_pair(0, 0)), Vector(player_num+1, 1.0));
+
+    for(int i=0; i<traverse_order.size(); i++){
+        ProceduralNode* node = static_cast<ProceduralNode*>(traverse_order[i]);
+        if(node -> is_terminal) continue;
+        int player = node -> player;
+        int num_actions = (player == 0) ? node -> chance.size : infosets[player][node -> infoset].children.size();
+
+        auto expand = [&](const int& action){
+            std::vector<std::pair<int, int>> parent_infoset = node -> parent_infoset;
+            if(player != 0) parent_infoset[player] = std::make_pair(node -> infoset, action);
+            Vector reach = node -> reach;
+            reach[player] *= GetProb(node, strategy_nodes[player].idx, action);
+            game->Child(node -> state.data(), action, child.data());
+            AddTraverseNode(child.data(), parent_infoset, reach);
+        };
+        if(current_traverse == Traverse::Enumerate || (current_traverse == Traverse::External && player == traverser)){
+            for(int action=0; action<num_actions; ++action) expand(action);
+        } else{
+            expand(Basic::Sample(GetProb(node, strategy_nodes[player].idx)));
+        }
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef PROCEDURALENVIRONMENT_H_
+#define PROCEDURALENVIRONMENT_H_
+
+#include "Environment/Environment.h"
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class GameDefinition {
+public:
+    /*
+        A game given by its rules instead of a materialized tree
+        A state is state_size integers chosen by the game, e.g. packed cards and betting history
+        All functions should be deterministic and should not keep references to the state
+        After Initialize, Update and ExploitabilityAsync may call them at the same time, so they should not write to members
+    */
+    int player_num, state_size;
+
+    GameDefinition(const int& player_num_, const int& state_size_) : player_num(player_num_), state_size(state_size_) {}
+
+    virtual void Root(int64_t* state) = 0;
+    virtual void Child(const int64_t* state, const int& action, int64_t* child) = 0;
+
+    virtual int ChildCount(const int64_t* state) = 0; // 0 iff the state is terminal
+    virtual int Player(const int64_t* state) = 0; // 0 for chance
+    virtual uint64_t InfosetKey(const int64_t* state) = 0; // states of the same player share an infoset iff they have the same key
+    virtual void ChanceProbs(const int64_t* state, double* probs) = 0; // probs[0], ..., probs[ChildCount(state)-1]
+    virtual void Payoff(const int64_t* state, double* payoff) = 0; // payoff[p-1] is the utility of player p
+
+    virtual std::string InfosetName(const int64_t* /*state*/) { return std::string(); } // empty names are replaced by infoset indices
+
+    virtual ~GameDefinition() {}
+};
+
+class ProceduralNode : public Node {
+public:
+    std::vector<int64_t> state;
+    std::vector<double> utility;
+
+    ProceduralNode(const int& player_, const int& infoset_, const int& player_num_);
+    double GetUtility(const int& player) override;
+};
+
+class ProceduralEnvironment : public Environment {
+public:
+    /*
+        No game tree is stored: only infosets, found by InfosetKey through a hash table per player
+        Sampled traversals (Outcome, External) create nodes only for the states on the sampled trajectories,
+        Enumerate creates nodes for the whole tree during each update and releases them afterwards
+        Exploitability and utility walk the states depth-first
+    */
+    std::shared_ptr<GameDefinition> game;
+    std::vector<std::unordered_map<uint64_t, int>> infoset_map;
+    std::deque<ProceduralNode> traverse_nodes; // nodes of the current traversal
+
+    std::vector<int64_t> walk_states; // state of each depth of the depth-first walk
+    std::vector<std::pair<int, int>> walk_parent_infoset;
+    std::vector<double> walk_utility;
+
+    ProceduralEnvironment(std::shared_ptr<GameDefinition> game_, const std::string& traverse_="Enumerate");
+
+    void Initialize() override;
+    int GetInfoset(const int& player, const int64_t* state, const int& num_actions, const std::vector<std::pair<int, int>>& parent_infoset);
+    void AddTraverseNode(const int64_t* state, const std::vector<std::pair<int, int>>& parent_infoset, const Vector& reach);
+    void GetTraverseOrder(const int& current_traverse, const std::vector<GraphNode>& strategy_nodes, const int& traverser) override;
+    void Walk(const int& depth, const double& chance_reach,
+              const std::function<void(const double&, const std::vector<std::pair<int, int>>&, const double*)>& func);
+    void WalkTerminals(const std::function<void(const double&, const std::vector<std::pair<int, int>>&, const double*)>& func) override;
+};
+
+#endif
@@ -1,7 +1,9 @@
 #include "Environment/SequenceForm.h"
 
 #include "Basic/Constants.h"
+#include "Basic/BasicFunction.h"
 
+#include <algorithm>
 #include <cmath>
 #include <stdexcept>
 
@@ -19,12 +21,7 @@ HistoryVersionStrategy::HistoryVersionStrategy(const int& n){
 }
 
 void HistoryVersionStrategy::UpdateStrategy(const Vector& strategy, const double& exploitability){
-    if(exploitability < best_exploitability){
-        for(int i=0; i<strategy.size; i++){
-            best_iterate[i] = strategy[i];
-        }
-        best_exploitability = exploitability;
-    }
+    UpdateBest(strategy, exploitability);
     for(int i=0; i<strategy.size; i++){
         last_iterate[i] = strategy[i];
         avg_iterate[i] = (avg_iterate[i] * (timestep / (timestep + 1.0))) + (strategy[i] / (timestep + 1.0));
@@ -33,6 +30,20 @@ void HistoryVersionStrategy::UpdateStrategy(const Vector& strategy, const double
     timestep += 1.0;
 }
 
+void HistoryVersionStrategy::UpdateBest(const Vector& strategy, const double& exploitability){
+    if(exploitability < best_exploitability){
+        for(int i=0; i<strategy.size; i++){
+            best_iterate[i] = strategy[i];
+        }
+        best_exploitability = exploitability;
+    }
+}
+
+void HistoryVersionStrategy::SetCandidate(const int& slot, const Vector& strategy){
+    if(candidates.size() <= slot) candidates.resize(slot + 1);
+    candidates[slot] = strategy;
+}
+
 SequenceForm::SequenceForm(std::vector<Infoset>* infosets_) : infosets{infosets_} {
     start_sequence.resize(infosets->size());
     end_sequence.resize(infosets->size());
@@ -47,7 +58,11 @@ SequenceForm::SequenceForm(std::vector<Infoset>* infosets_) : infosets{infosets_
     strategy = Vector(n, 0.0);
     gradient = Vector(n, 0.0);
     counterfactual_value = Vector(n, 0.0);
+    gradient_compensation = Vector(n, 0.0);
+    counterfactual_compensation = Vector(n, 0.0);
+    is_compensated = false;
     history_version_strategies.clear();
+    batch_size = 0;
 }
 
 int SequenceForm::GetIdx(const int& infoset, const int& action){
@@ -81,14 +96,40 @@ bool SequenceForm::IsSequenceForm(){
     return IsSequenceForm(strategy);
 }
 
-void SequenceForm::UpdateStrategy(const int& strategy_node_idx, const double& exploitability){
+HistoryVersionStrategy& SequenceForm::GetHistory(const int& strategy_node_idx){
     if(strategy_idx_map.size() <= strategy_node_idx)
         strategy_idx_map.resize(strategy_node_idx + 1, -1);
     if(strategy_idx_map[strategy_node_idx] == -1){
         strategy_idx_map[strategy_node_idx] = history_version_strategies.size();
         history_version_strategies.push_back(HistoryVersionStrategy(strategy.size));
     }
-    history_version_strategies[strategy_idx_map[strategy_node_idx]].UpdateStrategy(strategy, exploitability);
+    return history_version_strategies[strategy_idx_map[strategy_node_idx]];
+}
+
+void SequenceForm::UpdateStrategy(const int& strategy_node_idx, const double& exploitability){
+    GetHistory(strategy_node_idx).UpdateStrategy(strategy, exploitability);
+}
+
+double SequenceForm::GetStrategyMovement(const int& strategy_node_idx){
+    /*
+        L1 distance between the current strategy and the stored last-iterate, a cheap proxy of how far the iterate is from a fixed point
+    */
+    if(strategy_idx_map.size() <= strategy_node_idx || strategy_idx_map[strategy_node_idx] == -1)
+        return Constants::INF;
+    HistoryVersionStrategy& history = history_version_strategies[strategy_idx_map[strategy_node_idx]];
+    double movement = 0.0;
+    for(int i=0; i<strategy.size; ++i) movement += std::fabs(strategy[i] - history.last_iterate[i]);
+    return movement;
+}
+
+SequenceForm SequenceForm::Snapshot(){
+    /*
+        Copy of the current strategy with zero gradient, without the history versions, frozen strategies and batch buffers
+    */
+    SequenceForm snapshot(infosets);
+    snapshot.strategy = strategy;
+    snapshot.is_compensated = is_compensated;
+    return snapshot;
 }
 
 //std::vector<double> SequenceForm::GetStrategy(){
@@ -98,6 +139,7 @@ void SequenceForm::UpdateStrategy(const int& strategy_node_idx, const double& ex
 void SequenceForm::GetSequenceFormStrategy(const int& strategy_node_idx, const std::string& type_name){
     (*infosets)[0].reach = 1.0;
     gradient.Set(0.0); //reset gradient
+    gradient_compensation.Set(0.0);
     if(strategy_idx_map.size() <= strategy_node_idx)
         strategy_idx_map.resize(strategy_node_idx + 1, -1);
     if(type_name != "default" && strategy_idx_map[strategy_node_idx] == -1)
@@ -147,11 +189,44 @@ void SequenceForm::GetSequenceFormStrategy(const int& strategy_node_idx, const s
 }
 
 double SequenceForm::GetUtility(){
-    return strategy.Dot(gradient);
+    if(!is_compensated) return strategy.Dot(gradient);
+    double utility, compensation;
+    GetCompensatedUtility(utility, compensation);
+    return utility + compensation;
+}
+
+void SequenceForm::GetCompensatedUtility(double& utility, double& compensation){
+    utility = compensation = 0.0;
+    for(int i=0; i<strategy.size; ++i){
+        Basic::NeumaierMulAdd(utility, compensation, strategy[i], gradient[i]);
+        compensation += strategy[i] * gradient_compensation[i];
+    }
 }
 
 double SequenceForm::GetExploitability(){
     counterfactual_value = gradient;
+    if(is_compensated){
+        /*
+            Both the best-response value and the utility are kept as (value, compensation) pairs,
+            so the final subtraction does not cancel away the accumulated digits
+        */
+        counterfactual_compensation = gradient_compensation;
+        for(int i=infosets->size()-1; i>=1; --i){
+            Infoset& infoset = (*infosets)[i];
+            int best = start_sequence[i];
+            for(int j=start_sequence[i]+1; j<end_sequence[i]; ++j){
+                if(counterfactual_value[j] + counterfactual_compensation[j] > counterfactual_value[best] + counterfactual_compensation[best])
+                    best = j;
+            }
+            int idx = GetIdx(infoset.parent.first, infoset.parent.second);
+            Basic::NeumaierAdd(counterfactual_value[idx], counterfactual_compensation[idx], counterfactual_value[best]);
+            counterfactual_compensation[idx] += counterfactual_compensation[best];
+        }
+        double utility, compensation;
+        GetCompensatedUtility(utility, compensation);
+        return (counterfactual_value[0] - utility) + (counterfactual_compensation[0] - compensation);
+    }
+
     for(int i=infosets->size()-1; i>=1; --i){
         Infoset& infoset = (*infosets)[i];
         double ev = - Constants::INF;
@@ -162,4 +237,111 @@ double SequenceForm::GetExploitability(){
     }
 
     return counterfactual_value[0] - GetUtility();
-}
\ No newline at end of file
+}
+
+void SequenceForm::ResizeBatch(const int& batch_size_){
+    batch_size = batch_size_;
+    batch_strategy.assign(strategy.size * batch_size, 0.0);
+    batch_gradient.assign(strategy.size * batch_size, 0.0);
+    if(is_compensated) batch_gradient_compensation.assign(strategy.size * batch_size, 0.0);
+}
+
+void SequenceForm::SetBatchStrategy(const int& batch_idx){
+    /*
+        Copy the current sequence-form strategy into column batch_idx of batch_strategy
+    */
+    SetBatchStrategy(batch_idx, strategy);
+}
+
+void SequenceForm::SetBatchStrategy(const int& batch_idx, const Vector& input_strategy){
+    for(int i=0; i<strategy.size; ++i)
+        batch_strategy[i * batch_size + batch_idx] = input_strategy[i];
+}
+
+const Vector& SequenceForm::GetFrozenStrategy(const std::string& name){
+    auto it = frozen_strategies.find(name);
+    if(it == frozen_strategies.end())
+        throw std::invalid_argument("Frozen strategy " + name + " not found, please LoadStrategy(name) first.");
+    return it -> second;
+}
+
+std::vector<double> SequenceForm::GetBatchUtility(){
+    std::vector<double> utility(batch_size, 0.0);
+    if(is_compensated){
+        std::vector<double> compensation;
+        GetCompensatedBatchUtility(utility, compensation);
+        for(int b=0; b<batch_size; ++b) utility[b] += compensation[b];
+        return utility;
+    }
+    for(int i=0; i<strategy.size; ++i){
+        const double* x = &batch_strategy[i * batch_size];
+        const double* g = &batch_gradient[i * batch_size];
+        for(int b=0; b<batch_size; ++b) utility[b] += x[b] * g[b];
+    }
+    return utility;
+}
+
+void SequenceForm::GetCompensatedBatchUtility(std::vector<double>& utility, std::vector<double>& compensation){
+    utility.assign(batch_size, 0.0);
+    compensation.assign(batch_size, 0.0);
+    for(int i=0; i<strategy.size; ++i){
+        const double* x = &batch_strategy[i * batch_size];
+        const double* g = &batch_gradient[i * batch_size];
+        const double* gc = &batch_gradient_compensation[i * batch_size];
+        for(int b=0; b<batch_size; ++b){
+            Basic::NeumaierMulAdd(utility[b], compensation[b], x[b], g[b]);
+            compensation[b] += x[b] * gc[b];
+        }
+    }
+}
+
+std::vector<double> SequenceForm::GetBatchExploitability(){
+    batch_counterfactual_value = batch_gradient;
+    std::vector<double> ev(batch_size);
+    if(is_compensated){
+        batch_counterfactual_compensation = batch_gradient_compensation;
+        std::vector<double> ev_compensation(batch_size);
+        for(int i=infosets->size()-1; i>=1; --i){
+            Infoset& infoset = (*infosets)[i];
+            std::fill(ev.begin(), ev.end(), - Constants::INF);
+            std::fill(ev_compensation.begin(), ev_compensation.end(), 0.0);
+            for(int j=start_sequence[i]; j<end_sequence[i]; ++j){
+                const double* cf = &batch_counterfactual_value[j * batch_size];
+                const double* cc = &batch_counterfactual_compensation[j * batch_size];
+                for(int b=0; b<batch_size; ++b){
+                    bool is_better = cf[b] + cc[b] > ev[b] + ev_compensation[b];
+                    ev[b] = is_better ? cf[b] : ev[b];
+                    ev_compensation[b] = is_better ? cc[b] : ev_compensation[b];
+                }
+            }
+            int idx = GetIdx(infoset.parent.first, infoset.parent.second);
+            double* parent_cf = &batch_counterfactual_value[idx * batch_size];
+            double* parent_cc = &batch_counterfactual_compensation[idx * batch_size];
+            for(int b=0; b<batch_size; ++b){
+                Basic::NeumaierAdd(parent_cf[b], parent_cc[b], ev[b]);
+                parent_cc[b] += ev_compensation[b];
+            }
+        }
+
+        std::vector<double> utility, compensation, exploitability(batch_size);
+        GetCompensatedBatchUtility(utility, compensation);
+        for(int b=0; b<batch_size; ++b)
+            exploitability[b] = (batch_counterfactual_value[b] - utility[b]) + (batch_counterfactual_compensation[b] - compensation[b]);
+        return exploitability;
+    }
+
+    for(int i=infosets->size()-1; i>=1; --i){
+        Infoset& infoset = (*infosets)[i];
+        std::fill(ev.begin(), ev.end(), - Constants::INF);
+        for(int j=start_sequence[i]; j<end_sequence[i]; ++j){
+            const double* cf = &batch_counterfactual_value[j * batch_size];
+            for(int b=0; b<batch_size; ++b) ev[b] = std::max(ev[b], cf[b]);
+        }
+        double* parent_cf = &batch_counterfactual_value[GetIdx(infoset.parent.first, infoset.parent.second) * batch_size];
+        for(int b=0; b<batch_size; ++b) parent_cf[b] += ev[b];
+    }
+
+    std::vector<double> exploitability = GetBatchUtility();
+    for(int b=0; b<batch_size; ++b) exploitability[b] = batch_counterfactual_value[b] - exploitability[b];
+    return exploitability;
+}
@@ -12,10 +12,37 @@ class HistoryVersionStrategy{
 public:
     Vector last_iterate, best_iterate, avg_iterate, linear_avg_iterate;
     double best_exploitability, timestep;
+    std::vector<Vector> candidates; // snapshots waiting to be verified for best-iterate
 
     HistoryVersionStrategy();
     HistoryVersionStrategy(const int& n);
     void UpdateStrategy(const Vector& strategy, const double& exploitability);
+    void UpdateBest(const Vector& strategy, const double& exploitability);
+    void SetCandidate(const int& slot, const Vector& strategy);
+};
+
+class SparseStrategy{
+public:
+    /*
+        Compressed sparse rows, one row per infoset (infoset i is row i-1)
+        The entries of infoset i are indices[indptr[i-1]:indptr[i]] (action index) and values[indptr[i-1]:indptr[i]]
+    */
+    std::vector<int> indptr, indices;
+    std::vector<double> values;
+
+    SparseStrategy() : indptr{0} {}
+};
+
+class FlatValues{
+public:
+    /*
+        Values of all infosets of a player in one array, keyed by infoset index instead of infoset name (infoset i is row i-1)
+        The values of infoset i are values[indptr[i-1]:indptr[i]]
+    */
+    std::vector<int> indptr;
+    std::vector<double> values;
+
+    FlatValues() : indptr{0} {}
 };
 
 class SequenceForm{
@@ -23,20 +50,39 @@ public:
     std::vector<Infoset>* infosets;
     std::vector<int> start_sequence, end_sequence;
     Vector strategy, gradient, counterfactual_value;
+    Vector gradient_compensation, counterfactual_compensation; // rounding errors kept when is_compensated
+    bool is_compensated;
     std::vector<HistoryVersionStrategy> history_version_strategies;
     std::vector<int> strategy_idx_map;
 
+    int batch_size;
+    std::vector<double> batch_strategy, batch_gradient, batch_counterfactual_value; // [sequence x batch], row-major
+    std::vector<double> batch_gradient_compensation, batch_counterfactual_compensation;
+    std::unordered_map<std::string, Vector> frozen_strategies; // sequence-form strategies loaded by name
+
     SequenceForm(std::vector<Infoset>* infosets_);
 
     int GetIdx(const int& infoset, const int& action);
     bool IsSequenceForm(const Vector& input_strategy);
     bool IsSequenceForm();
+    HistoryVersionStrategy& GetHistory(const int& strategy_node_idx);
     void UpdateStrategy(const int& strategy_node_idx, const double& exploitability);
+    double GetStrategyMovement(const int& strategy_node_idx);
     void GetSequenceFormStrategy(const int& strategy_node_idx, const std::string& type_name="default");
+    SequenceForm Snapshot();
     //std::vector<double> GetStrategy();
 
     double GetUtility();
     double GetExploitability();
+    void GetCompensatedUtility(double& utility, double& compensation);
+
+    void ResizeBatch(const int& batch_size_);
+    void SetBatchStrategy(const int& batch_idx);
+    void SetBatchStrategy(const int& batch_idx, const Vector& input_strategy);
+    const Vector& GetFrozenStrategy(const std::string& name);
+    std::vector<double> GetBatchUtility();
+    void GetCompensatedBatchUtility(std::vector<double>& utility, std::vector<double>& compensation);
+    std::vector<double> GetBatchExploitability();
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,287 @@
+#include "Environment/StrategyFile.h"
+#include "Environment/Checkpoint.h"
+
+#include "Basic/FileReader.h"
+#include "Basic/BasicFunction.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#ifdef LITEEFG_WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef LITEEFG_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+std::string StrategyTable::GetName(const size_t& idx) const{
+    if(!names.IsNamed(idx)) return std::to_string(infoset[idx]);
+    return std::string(names.View(idx));
+}
+
+std::vector<std::string> StrategyTable::GetNames() const{
+    std::vector<std::string> ret;
+    ret.reserve(num_infosets());
+    for(size_t i=0; i<num_infosets(); ++i) ret.push_back(GetName(i));
+    return ret;
+}
+
+std::vector<int32_t> StrategyTable::GetRowInfosets() const{
+    std::vector<int32_t> ret(action.size());
+    for(size_t i=0; i<num_infosets(); ++i)
+        std::fill(ret.begin() + indptr[i], ret.begin() + indptr[i+1], (int32_t)i);
+    return ret;
+}
+
+class StrategyColumn {
+public:
+    char* data;
+    int64_t count, element_size;
+};
+
+static std::vector<StrategyColumn> GetColumns(StrategyTable& table){
+    // The order of the columns in the file
+    return {
+        {(char*)table.player.data(), (int64_t)table.player.size(), sizeof(int32_t)},
+        {(char*)table.infoset.data(), (int64_t)table.infoset.size(), sizeof(int32_t)},
+        {(char*)table.indptr.data(), (int64_t)table.indptr.size(), sizeof(int64_t)},
+        {(char*)table.names.offsets.data(), (int64_t)table.names.offsets.size(), sizeof(int64_t)},
+        {(char*)table.names.chars.data(), (int64_t)table.names.chars.size(), sizeof(char)},
+        {(char*)table.action.data(), (int64_t)table.action.size(), sizeof(int32_t)},
+        {(char*)table.probability.data(), (int64_t)table.probability.size(), sizeof(double)},
+    };
+}
+
+static void Shuffle(const char* input, char* output, const int64_t& count, const int64_t& element_size){
+    // Byte j of element i is moved to output[j * count + i]
+    for(int64_t i=0; i<count; ++i)
+        for(int64_t j=0; j<element_size; ++j) output[j * count + i] = input[i * element_size + j];
+}
+
+static void Unshuffle(const char* input, char* output, const int64_t& count, const int64_t& element_size){
+    for(int64_t i=0; i<count; ++i)
+        for(int64_t j=0; j<element_size; ++j) output[i * element_size + j] = input[j * count + i];
+}
+
+static std::vector<char> Compress(const std::vector<char>& input, int& codec){
+    // The chunk is stored uncompressed (codec is set to none) if compression does not make it smaller
+    std::vector<char> output;
+#ifdef LITEEFG_WITH_ZSTD
+    if(codec == StrategyFile::Codec::zstd){
+        output.resize(ZSTD_compressBound(input.size()));
+        size_t size = ZSTD_compress(output.data(), output.size(), input.data(), input.size(), 3);
+        if(ZSTD_isError(size)) throw std::runtime_error(std::string("zstd compression failed: ") + ZSTD_getErrorName(size));
+        output.resize(size);
+    }
+#endif
+#ifdef LITEEFG_WITH_ZLIB
+    if(codec == StrategyFile::Codec::zlib){
+        uLongf size = compressBound(input.size());
+        output.resize(size);
+        if(compress2((Bytef*)output.data(), &size, (const Bytef*)input.data(), input.size(), Z_BEST_SPEED) != Z_OK)
+            throw std::runtime_error("zlib compression failed");
+        output.resize(size);
+    }
+#endif
+    if(codec == StrategyFile::Codec::none || output.size() >= input.size()){
+        codec = StrategyFile::Codec::none;
+        return input;
+    }
+    return output;
+}
+
+static void Decompress(const char* input, const int64_t& input_size, char* output, const int64_t& output_size, const int& codec){
+    if(codec == StrategyFile::Codec::none){
+        if(input_size != output_size) throw std::runtime_error("Strategy file is corrupted: chunk size mismatch");
+        memcpy(output, input, output_size);
+        return;
+    }
+    if(codec == StrategyFile::Codec::zlib){
+#ifdef LITEEFG_WITH_ZLIB
+        uLongf size = output_size;
+        if(uncompress((Bytef*)output, &size, (const Bytef*)input, input_size) != Z_OK || size != output_size)
+            throw std::runtime_error("Strategy file is corrupted: zlib decompression failed");
+        return;
+#else
+        throw std::runtime_error("the strategy file is compressed by zlib, but LiteEFG is built without zlib");
+#endif
+    }
+    if(codec == StrategyFile::Codec::zstd){
+#ifdef LITEEFG_WITH_ZSTD
+        size_t size = ZSTD_decompress(output, output_size, input, input_size);
+        if(ZSTD_isError(size) || size != output_size)
+            throw std::runtime_error("Strategy file is corrupted: zstd decompression failed");
+        return;
+#else
+        throw std::runtime_error("the strategy file is compressed by zstd, but LiteEFG is built without libzstd");
+#endif
+    }
+    throw std::runtime_error("Strategy file is corrupted: unknown codec " + std::to_string(codec));
+}
+
+int StrategyFile::DefaultCodec(){
+#if defined(LITEEFG_WITH_ZSTD)
+    return Codec::zstd;
+#elif defined(LITEEFG_WITH_ZLIB)
+    return Codec::zlib;
+#else
+    return Codec::none;
+#endif
+}
+
+int StrategyFile::GetCodec(const std::string& codec){
+    if(codec == "default") return DefaultCodec();
+    if(codec == "none") return Codec::none;
+#ifdef LITEEFG_WITH_ZLIB
+    if(codec == "zlib") return Codec::zlib;
+#endif
+#ifdef LITEEFG_WITH_ZSTD
+    if(codec == "zstd") return Codec::zstd;
+#endif
+    throw std::invalid_argument("Unsupported codec " + codec + ", LiteEFG is built with: {default, none"
+#ifdef LITEEFG_WITH_ZLIB
+                                ", zlib"
+#endif
+#ifdef LITEEFG_WITH_ZSTD
+                                ", zstd"
+#endif
+                                "}");
+}
+
+void StrategyFile::Write(const std::string& file_name, const StrategyTable& table, const int& codec, const int& num_threads){
+    /*
+        The chunks are compressed by num_threads threads into memory, then written in order after the directory
+    */
+    std::vector<StrategyColumn> columns = GetColumns(const_cast<StrategyTable&>(table));
+    std::vector<StrategyFileChunk> chunks;
+    for(int c=0; c<columns.size(); ++c){
+        for(int64_t first=0; first<columns[c].count; first+=chunk_size){
+            StrategyFileChunk chunk;
+            chunk.column = c;
+            chunk.codec = codec;
+            chunk.first = first;
+            chunk.count = std::min(chunk_size, columns[c].count - first);
+            chunks.push_back(chunk);
+        }
+    }
+
+    std::vector<std::vector<char>> data(chunks.size());
+    std::atomic<size_t> next{0};
+    Basic::ParallelFor(std::min<int>(Basic::GetNumThreads(num_threads), std::max<size_t>(chunks.size(), 1)), [&](const int&){
+        std::vector<char> shuffled;
+        for(size_t k=next++; k<chunks.size(); k=next++){
+            StrategyColumn& column = columns[chunks[k].column];
+            shuffled.resize(chunks[k].count * column.element_size);
+            Shuffle(column.data + chunks[k].first * column.element_size, shuffled.data(), chunks[k].count, column.element_size);
+            CheckpointHash hash;
+            hash.Add(shuffled.data(), shuffled.size());
+            chunks[k].checksum = hash.value;
+            data[k] = Compress(shuffled, chunks[k].codec);
+        }
+    });
+
+    StrategyFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, magic, 8);
+    header.version = version;
+    header.byte_order = 0x01020304;
+    header.num_infosets = table.num_infosets();
+    header.num_rows = table.action.size();
+    header.name_bytes = table.names.chars.size();
+    header.num_chunks = chunks.size();
+
+    int64_t offset = sizeof(header) + sizeof(StrategyFileChunk) * chunks.size();
+    for(size_t k=0; k<chunks.size(); ++k){
+        chunks[k].offset = offset;
+        chunks[k].compressed_bytes = data[k].size();
+        offset += (data[k].size() + 7) / 8 * 8;
+    }
+
+    std::ofstream out(file_name, std::ios::binary);
+    if(!out) throw std::runtime_error("Cannot open file " + file_name);
+    static const char padding[8] = {0};
+    out.write((const char*)&header, sizeof(header));
+    out.write((const char*)chunks.data(), sizeof(StrategyFileChunk) * chunks.size());
+    for(auto& chunk_data : data){
+        out.write(chunk_data.data(), chunk_data.size());
+        if(chunk_data.size() % 8 != 0) out.write(padding, 8 - chunk_data.size() % 8);
+    }
+    if(!out) throw std::runtime_error("Failed to write file " + file_name);
+}
+
+StrategyTable StrategyFile::Read(const std::string& file_name, const int& num_threads){
+    /*
+        Read the file written by Write from its memory mapping, the chunks are decompressed by num_threads threads into the columns
+    */
+    FileReader file_reader(file_name);
+    const char *data = file_reader.data;
+    size_t file_size = file_reader.file_size;
+    StrategyFileHeader header;
+    if(file_size < sizeof(header) || memcmp(data, magic, 8) != 0)
+        throw std::runtime_error("File " + file_name + " is not a LiteEFG strategy file");
+    memcpy(&header, data, sizeof(header));
+    if(header.byte_order != 0x01020304) throw std::runtime_error("Strategy file is written by a machine with different endianness");
+    if(header.version != version)
+        throw std::runtime_error("Unsupported strategy file version " + std::to_string(header.version) + ", expected " + std::to_string(version));
+    if(header.num_infosets < 0 || header.num_rows < 0 || header.name_bytes < 0 || header.num_chunks < 0
+       || (file_size - sizeof(header)) / sizeof(StrategyFileChunk) < (size_t)header.num_chunks)
+        throw std::runtime_error("Strategy file is truncated");
+
+    // The directory is checked against the header before any column is allocated
+    std::vector<StrategyFileChunk> chunks(header.num_chunks);
+    if(header.num_chunks > 0) memcpy(chunks.data(), data + sizeof(header), sizeof(StrategyFileChunk) * chunks.size());
+    std::vector<int64_t> counts{header.num_infosets, header.num_infosets, header.num_infosets+1, header.num_infosets+1, header.name_bytes, header.num_rows, header.num_rows};
+    std::vector<std::vector<std::pair<int64_t, int64_t>>> ranges(counts.size()); // [first, end) of the chunks of each column
+    for(auto& chunk : chunks){
+        if(chunk.column < 0 || chunk.column >= counts.size() || chunk.first < 0 || chunk.count < 0 || chunk.count > chunk_size
+           || chunk.first > counts[chunk.column] - chunk.count || chunk.offset < 0 || chunk.compressed_bytes < 0
+           || (size_t)chunk.offset > file_size || (size_t)chunk.compressed_bytes > file_size - chunk.offset)
+            throw std::runtime_error("Strategy file is corrupted: invalid chunk");
+        ranges[chunk.column].push_back({chunk.first, chunk.first + chunk.count});
+    }
+    for(int c=0; c<counts.size(); ++c){
+        // the chunks of a column should tile it exactly, so that no element is left unread or written twice
+        std::sort(ranges[c].begin(), ranges[c].end());
+        int64_t end = 0;
+        for(auto& range : ranges[c]){
+            if(range.first != end) throw std::runtime_error("Strategy file is corrupted: chunks of column " + std::to_string(c) + " overlap or leave a gap");
+            end = range.second;
+        }
+        if(end != counts[c]) throw std::runtime_error("Strategy file is corrupted: missing chunks");
+    }
+
+    StrategyTable table;
+    table.player.resize(header.num_infosets);
+    table.infoset.resize(header.num_infosets);
+    table.indptr.resize(header.num_infosets+1);
+    table.names.offsets.resize(header.num_infosets+1);
+    table.names.chars.resize(header.name_bytes);
+    table.action.resize(header.num_rows);
+    table.probability.resize(header.num_rows);
+    std::vector<StrategyColumn> columns = GetColumns(table);
+
+    std::atomic<size_t> next{0};
+    Basic::ParallelFor(std::min<int>(Basic::GetNumThreads(num_threads), std::max<size_t>(chunks.size(), 1)), [&](const int&){
+        std::vector<char> shuffled;
+        for(size_t k=next++; k<chunks.size(); k=next++){
+            StrategyColumn& column = columns[chunks[k].column];
+            shuffled.resize(chunks[k].count * column.element_size);
+            Decompress(data + chunks[k].offset, chunks[k].compressed_bytes, shuffled.data(), shuffled.size(), chunks[k].codec);
+            CheckpointHash hash;
+            hash.Add(shuffled.data(), shuffled.size());
+            if(hash.value != chunks[k].checksum) throw std::runtime_error("Strategy file is corrupted: checksum mismatch in chunk " + std::to_string(k));
+            Unshuffle(shuffled.data(), column.data + chunks[k].first * column.element_size, chunks[k].count, column.element_size);
+        }
+    });
+
+    for(int64_t i=0; i<header.num_infosets; ++i){
+        if(table.indptr[i] < 0 || table.indptr[i] > table.indptr[i+1] || table.names.offsets[i] < 0 || table.names.offsets[i] > table.names.offsets[i+1])
+            throw std::runtime_error("Strategy file is corrupted: invalid offsets");
+    }
+    if(table.indptr[0] != 0 || table.indptr.back() != header.num_rows || table.names.offsets[0] != 0 || table.names.offsets.back() != header.name_bytes)
+        throw std::runtime_error("Strategy file is corrupted: invalid offsets");
+    return table;
+}
@@ -0,0 +1,66 @@
+#ifndef STRATEGYFILE_H_
+#define STRATEGYFILE_H_
+
+#include "Environment/Infoset.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class StrategyTable {
+public:
+    /*
+        Strategy of all players in columns. Infoset i (counted over all players) is infoset infoset[i] of player player[i], named names[i],
+        and its rows are indptr[i], ..., indptr[i+1]-1. Row k is action action[k] played with probability probability[k]
+        Unnamed infosets are named by infoset[i], as in Environment::GetInfosetNames
+    */
+    std::vector<int32_t> player, infoset;
+    std::vector<int64_t> indptr{0};
+    InfosetNames names;
+    std::vector<int32_t> action;
+    std::vector<double> probability;
+
+    size_t num_infosets() const { return player.size(); }
+    std::string GetName(const size_t& idx) const;
+    std::vector<std::string> GetNames() const;
+    std::vector<int32_t> GetRowInfosets() const; // infoset of each row
+};
+
+class StrategyFileHeader {
+public:
+    char magic[8];
+    uint32_t version, byte_order; // byte_order is written as 0x01020304 to detect files from machines with another endianness
+    int64_t num_infosets, num_rows, name_bytes, num_chunks;
+};
+
+class StrategyFileChunk {
+public:
+    // Elements first, ..., first+count-1 of column, stored at offset of the file in compressed_bytes bytes
+    int32_t column, codec;
+    int64_t first, count, offset, compressed_bytes;
+    uint64_t checksum; // CheckpointHash of the elements before compression
+};
+
+namespace StrategyFile {
+    /*
+        Columnar strategy file: a header, the directory of chunks, then the chunks. Each column of StrategyTable is split into chunks
+        of at most chunk_size elements, which are compressed independently, so both writing and reading run on num_threads threads
+        Before compression, the bytes of the elements of a chunk are grouped by their position in the element (byte shuffle),
+        which puts the sign and exponent bytes of the probabilities together and compresses much better than the interleaved values
+    */
+    enum Codec {
+        none = 0,
+        zlib = 1,
+        zstd = 2,
+    };
+    static constexpr char magic[9] = "LiteEFGs";
+    static const unsigned int version = 1;
+    static const int64_t chunk_size = 1 << 20;
+
+    int DefaultCodec(); // zstd if LiteEFG is built with libzstd, otherwise zlib if built with zlib, otherwise none
+    int GetCodec(const std::string& codec);
+    void Write(const std::string& file_name, const StrategyTable& table, const int& codec, const int& num_threads=0);
+    StrategyTable Read(const std::string& file_name, const int& num_threads=0);
+};
+
+#endif
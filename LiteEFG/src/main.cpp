@@ -7,11 +7,16 @@
 #include "Computation/Static.h"
 #include "Computation/Projection.h"
 #include "Computation/GraphNode.h"
+#include "Computation/Kernels.h"
 
 #include "Environment/Environment.h"
 #include "Environment/NFG/NFG.h"
 #include "Environment/Leduc/Leduc.h"
 #include "Environment/FileEnvironment/FileEnvironment.h"
+#include "Environment/ProceduralEnvironment/ProceduralEnvironment.h"
+#include "Environment/Poker/Poker.h"
+#include "Environment/BatchedEnvironment/BatchedEnvironment.h"
+#include "Environment/StrategyFile.h"
 
 #include "Basic/BasicFunction.h"
 
@@ -20,9 +25,19 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 #include <pybind11/operators.h>
+#include <pybind11/numpy.h>
 
 namespace py = pybind11;
 
+std::vector<Tensor> ToTensors(const std::vector<py::array_t<double, py::array::c_style | py::array::forcecast>>& arrays){
+    std::vector<Tensor> tensors;
+    for(auto& array : arrays){
+        std::vector<int> shape(array.shape(), array.shape() + array.ndim());
+        tensors.push_back(Tensor(std::vector<double>(array.data(), array.data() + array.size()), shape));
+    }
+    return tensors;
+}
+
 PYBIND11_MODULE(_LiteEFG, m) {
     py::class_<Vector>(m, "Vector")
         .def(py::init<>()) 
@@ -103,12 +118,22 @@ PYBIND11_MODULE(_LiteEFG, m) {
 
     py::class_<Graph>(m, "Graph")
         .def(py::init<>())
+        .def("__enter__", &Graph::Enter, py::return_value_policy::reference)
+        .def("__exit__", &Graph::Exit)
         .def_readonly("utility", &Graph::utility)
         .def_readonly("opponent_reach_prob", &Graph::opponent_reach_prob)
         .def_readonly("reach_prob", &Graph::reach_prob)
         .def_readonly("action_set_size", &Graph::action_set_size)
         .def_readonly("subtree_size", &Graph::subtree_size);
 
+    py::class_<KernelNodes>(m, "Kernel")
+        .def_readonly("name", &KernelNodes::name)
+        .def_readonly("nodes", &KernelNodes::nodes)
+        .def_readonly("alternating", &KernelNodes::Is_Alternating);
+
+    m.def("kernels", Kernels::Names);
+    m.def("kernel", Kernels::Build, py::arg("graph"), py::arg("name"), py::arg("params") = KernelParameters());
+
     py::class_<GraphNodeStatus, std::shared_ptr<GraphNodeStatus>>(m, "GraphNodeStatus")
         .def(py::init<>())
         .def("__enter__", &GraphNodeStatus::Enter, py::return_value_policy::reference)
@@ -120,20 +145,204 @@ PYBIND11_MODULE(_LiteEFG, m) {
     py::class_<BackwardNodeStatus, GraphNodeStatus, std::shared_ptr<BackwardNodeStatus>>(m, "backward")
         .def(py::init<const bool&, const int&>(), py::arg("is_static") = false, py::arg("color") = 0);
 
+    py::class_<SparseStrategy, std::shared_ptr<SparseStrategy>>(m, "SparseStrategy")
+        .def(py::init<>())
+        .def(py::init([](const py::array_t<int, py::array::c_style | py::array::forcecast>& indptr,
+                         const py::array_t<int, py::array::c_style | py::array::forcecast>& indices,
+                         const py::array_t<double, py::array::c_style | py::array::forcecast>& values) {
+                auto sparse = std::make_shared<SparseStrategy>();
+                sparse->indptr.assign(indptr.data(), indptr.data() + indptr.size());
+                sparse->indices.assign(indices.data(), indices.data() + indices.size());
+                sparse->values.assign(values.data(), values.data() + values.size());
+                return sparse;
+            }), py::arg("indptr"), py::arg("indices"), py::arg("values"))
+        // The arrays below are views of the C++ storage, which is kept alive by the SparseStrategy object
+        .def_property_readonly("indptr", [](py::object self) {
+                auto& sparse = self.cast<SparseStrategy&>();
+                return py::array_t<int>(sparse.indptr.size(), sparse.indptr.data(), self);
+            })
+        .def_property_readonly("indices", [](py::object self) {
+                auto& sparse = self.cast<SparseStrategy&>();
+                return py::array_t<int>(sparse.indices.size(), sparse.indices.data(), self);
+            })
+        .def_property_readonly("values", [](py::object self) {
+                auto& sparse = self.cast<SparseStrategy&>();
+                return py::array_t<double>(sparse.values.size(), sparse.values.data(), self);
+            });
+
+    py::class_<FlatValues, std::shared_ptr<FlatValues>>(m, "FlatValues")
+        // The arrays below are views of the C++ storage, which is kept alive by the FlatValues object
+        .def_property_readonly("indptr", [](py::object self) {
+                auto& flat = self.cast<FlatValues&>();
+                return py::array_t<int>(flat.indptr.size(), flat.indptr.data(), self);
+            })
+        .def_property_readonly("values", [](py::object self) {
+                auto& flat = self.cast<FlatValues&>();
+                return py::array_t<double>(flat.values.size(), flat.values.data(), self);
+            });
+
+    py::class_<StrategyTable, std::shared_ptr<StrategyTable>>(m, "StrategyTable")
+        // The arrays below are views of the C++ storage, which is kept alive by the StrategyTable object
+        .def_property_readonly("player", [](py::object self) {
+                auto& table = self.cast<StrategyTable&>();
+                return py::array_t<int32_t>(table.player.size(), table.player.data(), self);
+            })
+        .def_property_readonly("infoset", [](py::object self) {
+                auto& table = self.cast<StrategyTable&>();
+                return py::array_t<int32_t>(table.infoset.size(), table.infoset.data(), self);
+            })
+        .def_property_readonly("indptr", [](py::object self) {
+                auto& table = self.cast<StrategyTable&>();
+                return py::array_t<int64_t>(table.indptr.size(), table.indptr.data(), self);
+            })
+        .def_property_readonly("action", [](py::object self) {
+                auto& table = self.cast<StrategyTable&>();
+                return py::array_t<int32_t>(table.action.size(), table.action.data(), self);
+            })
+        .def_property_readonly("probability", [](py::object self) {
+                auto& table = self.cast<StrategyTable&>();
+                return py::array_t<double>(table.probability.size(), table.probability.data(), self);
+            })
+        .def_property_readonly("row_infoset", [](const StrategyTable& table) {
+                std::vector<int32_t> rows = table.GetRowInfosets();
+                py::array_t<int32_t> ret(rows.size());
+                std::copy(rows.begin(), rows.end(), ret.mutable_data());
+                return ret;
+            })
+        .def("names", &StrategyTable::GetNames)
+        .def("__len__", &StrategyTable::num_infosets);
+
+    m.def("read_strategy", StrategyFile::Read, py::call_guard<py::gil_scoped_release>(), py::arg("path"), py::arg("num_threads") = 0);
+
+    py::class_<UpdateStep>(m, "UpdateStep")
+        .def(py::init([](const GraphNode& strategy, const int& upd_player, const std::vector<int>& upd_color, const std::string& traverse_type, const int& period, const std::vector<int>& phases, const int& start, const int& stop) {
+                return UpdateStep({strategy}, upd_player, upd_color, traverse_type, period, phases, start, stop);
+            }), py::arg("strategy"), py::arg("upd_player") = -1, py::arg("upd_color") = std::vector<int>{-1}, py::arg("traverse_type") = "default", py::arg("period") = 1, py::arg("phases") = std::vector<int>{0}, py::arg("start") = 1, py::arg("stop") = 0)
+        .def(py::init<const std::vector<GraphNode>&, const int&, const std::vector<int>&, const std::string&, const int&, const std::vector<int>&, const int&, const int&>(), py::arg("strategies"), py::arg("upd_player") = -1, py::arg("upd_color") = std::vector<int>{-1}, py::arg("traverse_type") = "default", py::arg("period") = 1, py::arg("phases") = std::vector<int>{0}, py::arg("start") = 1, py::arg("stop") = 0);
+
+    py::class_<ExploitabilityFuture>(m, "ExploitabilityFuture")
+        .def("done", &ExploitabilityFuture::Done)
+        .def("result", &ExploitabilityFuture::Get, py::call_guard<py::gil_scoped_release>());
+
     py::class_<Environment, std::shared_ptr<Environment>>(m, "Environment")
-        .def("set_graph", &Environment::SetGraph, py::arg("graph"))
-        .def("update", py::overload_cast<const GraphNode&, const int&, std::vector<int>, const std::string&>(&Environment::Update), py::arg("strategy"), py::arg("upd_player") = -1, py::arg("upd_color")=std::vector<int>{-1}, py::arg("traverse_type")="default")
-        .def("update", py::overload_cast<std::vector<GraphNode>, const int&, std::vector<int>, const std::string&>(&Environment::Update), py::arg("strategies"), py::arg("upd_player") = -1, py::arg("upd_color")=std::vector<int>{-1}, py::arg("traverse_type")="default")
-        .def("update_strategy", py::overload_cast<const GraphNode&, const bool&>(&Environment::UpdateStrategy), py::arg("strategy"), py::arg("update_best") = false)
-        .def("exploitability", py::overload_cast<const GraphNode&, const std::string&>(&Environment::Exploitability), py::arg("strategy"), py::arg("type_name") = "default")
-        .def("exploitability", py::overload_cast<const std::vector<GraphNode>&, const std::string&>(&Environment::Exploitability), py::arg("strategy"), py::arg("type_name") = "default")
-        .def("utility", py::overload_cast<const GraphNode&, const std::string&>(&Environment::Utility), py::arg("strategy"), py::arg("type_name") = "default")
-        .def("utility", py::overload_cast<const std::vector<GraphNode>&, const std::string&>(&Environment::Utility), py::arg("strategy"), py::arg("type_name") = "default")
-        .def("get_value", &Environment::GetValue, py::arg("player"), py::arg("node"))
-        .def("get_strategy", &Environment::GetStrategy, py::arg("player"), py::arg("strategy"), py::arg("type_name") = "default")
-        .def("set_value", py::overload_cast<const int&, const GraphNode&, const std::vector<std::vector<double>>&>(&Environment::SetValue), py::arg("player"), py::arg("node"), py::arg("values"))
-        .def("set_value", py::overload_cast<const int&, const GraphNode&, const std::vector<double>&>(&Environment::SetValue), py::arg("player"), py::arg("node"), py::arg("values"));
+        .def("set_graph", &Environment::SetGraph, py::call_guard<py::gil_scoped_release>(), py::arg("graph"))
+        .def("set_compensated_summation", &Environment::SetCompensatedSummation, py::arg("is_compensated") = true)
+        .def("update", py::overload_cast<const GraphNode&, const int&, std::vector<int>, const std::string&>(&Environment::Update), py::call_guard<py::gil_scoped_release>(), py::arg("strategy"), py::arg("upd_player") = -1, py::arg("upd_color")=std::vector<int>{-1}, py::arg("traverse_type")="default")
+        .def("update", py::overload_cast<std::vector<GraphNode>, const int&, std::vector<int>, const std::string&>(&Environment::Update), py::call_guard<py::gil_scoped_release>(), py::arg("strategies"), py::arg("upd_player") = -1, py::arg("upd_color")=std::vector<int>{-1}, py::arg("traverse_type")="default")
+        .def("update_strategy", py::overload_cast<const GraphNode&, const bool&>(&Environment::UpdateStrategy), py::call_guard<py::gil_scoped_release>(), py::arg("strategy"), py::arg("update_best") = false)
+        .def("run", py::overload_cast<const std::vector<UpdateStep>&, const int&, const GraphNode&, const std::string&, const int&, const bool&, const int&>(&Environment::Run), py::call_guard<py::gil_scoped_release>(), py::arg("schedule"), py::arg("iterations"), py::arg("strategy"), py::arg("type_name") = "default", py::arg("eval_every") = 0, py::arg("update_best") = false, py::arg("update_strategy_every") = 1)
+        .def("run", py::overload_cast<const std::vector<UpdateStep>&, const int&, const std::vector<GraphNode>&, const std::string&, const int&, const bool&, const int&>(&Environment::Run), py::call_guard<py::gil_scoped_release>(), py::arg("schedule"), py::arg("iterations"), py::arg("strategy"), py::arg("type_name") = "default", py::arg("eval_every") = 0, py::arg("update_best") = false, py::arg("update_strategy_every") = 1)
+        .def_property("run_iterations", [](Environment& self) {
+                std::lock_guard<std::recursive_mutex> lock(self.mutex);
+                return self.run_iterations;
+            }, [](Environment& self, const int& iterations) {
+                std::lock_guard<std::recursive_mutex> lock(self.mutex);
+                self.run_iterations = iterations;
+            })
+        .def("set_best_iterate_tracking", &Environment::SetBestIterateTracking, py::arg("eval_freq"), py::arg("num_candidates") = 0)
+        .def("exploitability", py::overload_cast<const GraphNode&, const std::string&>(&Environment::Exploitability), py::call_guard<py::gil_scoped_release>(), py::arg("strategy"), py::arg("type_name") = "default")
+        .def("exploitability", py::overload_cast<const std::vector<GraphNode>&, const std::string&>(&Environment::Exploitability), py::call_guard<py::gil_scoped_release>(), py::arg("strategy"), py::arg("type_name") = "default")
+        .def("exploitability_async", py::overload_cast<const GraphNode&, const std::string&>(&Environment::ExploitabilityAsync), py::call_guard<py::gil_scoped_release>(), py::keep_alive<0, 1>(), py::arg("strategy"), py::arg("type_name") = "default")
+        .def("exploitability_async", py::overload_cast<const std::vector<GraphNode>&, const std::string&>(&Environment::ExploitabilityAsync), py::call_guard<py::gil_scoped_release>(), py::keep_alive<0, 1>(), py::arg("strategy"), py::arg("type_name") = "default")
+        .def("utility", py::overload_cast<const GraphNode&, const std::string&>(&Environment::Utility), py::call_guard<py::gil_scoped_release>(), py::arg("strategy"), py::arg("type_name") = "default")
+        .def("utility", py::overload_cast<const std::vector<GraphNode>&, const std::string&>(&Environment::Utility), py::call_guard<py::gil_scoped_release>(), py::arg("strategy"), py::arg("type_name") = "default")
+        .def("exploitability_batch", py::overload_cast<const std::vector<GraphNode>&, const std::vector<std::string>&>(&Environment::BatchExploitability), py::call_guard<py::gil_scoped_release>(), py::arg("strategies"), py::arg("type_names") = std::vector<std::string>{"default"})
+        .def("exploitability_batch", py::overload_cast<const std::vector<std::vector<GraphNode>>&, const std::vector<std::string>&>(&Environment::BatchExploitability), py::call_guard<py::gil_scoped_release>(), py::arg("strategies"), py::arg("type_names") = std::vector<std::string>{"default"})
+        .def("utility_batch", py::overload_cast<const std::vector<GraphNode>&, const std::vector<std::string>&>(&Environment::BatchUtility), py::call_guard<py::gil_scoped_release>(), py::arg("strategies"), py::arg("type_names") = std::vector<std::string>{"default"})
+        .def("utility_batch", py::overload_cast<const std::vector<std::vector<GraphNode>>&, const std::vector<std::string>&>(&Environment::BatchUtility), py::call_guard<py::gil_scoped_release>(), py::arg("strategies"), py::arg("type_names") = std::vector<std::string>{"default"})
+        .def("load_strategy", &Environment::LoadStrategy, py::arg("name"), py::arg("player"), py::arg("strategy"))
+        .def("freeze_strategy", &Environment::FreezeStrategy, py::call_guard<py::gil_scoped_release>(), py::arg("name"), py::arg("strategy"), py::arg("type_name") = "default")
+        .def("cross_play_utility", &Environment::CrossPlayUtility, py::call_guard<py::gil_scoped_release>(), py::arg("profiles"))
+        .def("matchup_matrix", &Environment::MatchupMatrix, py::call_guard<py::gil_scoped_release>(), py::arg("row_names"), py::arg("col_names"))
+        .def("get_value", &Environment::GetValue, py::call_guard<py::gil_scoped_release>(), py::arg("player"), py::arg("node"))
+        .def("get_strategy", &Environment::GetStrategy, py::call_guard<py::gil_scoped_release>(), py::arg("player"), py::arg("strategy"), py::arg("type_name") = "default")
+        .def("get_flat_value", &Environment::GetFlatValue, py::call_guard<py::gil_scoped_release>(), py::arg("player"), py::arg("node"))
+        .def("get_value_array", [](Environment& env, const int& player, const GraphNode& node) {
+                std::shared_ptr<FlatValues> values;
+                {
+                    py::gil_scoped_release release;
+                    values = std::make_shared<FlatValues>(env.GetFlatValue(player, node));
+                }
+                py::object flat = py::cast(values);
+                return py::make_tuple(flat.attr("values"), flat.attr("indptr"));
+            }, py::arg("player"), py::arg("node"))
+        .def("get_flat_strategy", &Environment::GetFlatStrategy, py::call_guard<py::gil_scoped_release>(), py::arg("player"), py::arg("strategy"), py::arg("type_name") = "default")
+        .def("get_infoset_names", &Environment::GetInfosetNames, py::arg("player"), py::arg("indices") = std::vector<int>())
+        .def("set_value", [](Environment& env, const int& player, const GraphNode& node, const py::array& values) {
+                // NumPy arrays are read through the buffer, lists fall through to the overloads below
+                auto buffer = py::array_t<double, py::array::c_style | py::array::forcecast>::ensure(values);
+                if(!buffer) throw std::invalid_argument("values should be an array of numbers");
+                py::gil_scoped_release release; // buffer keeps the array alive
+                env.SetValue(player, node, buffer.data(), buffer.size());
+            }, py::arg("player"), py::arg("node"), py::arg("values").noconvert())
+        .def("set_value", py::overload_cast<const int&, const GraphNode&, const std::vector<std::vector<double>>&>(&Environment::SetValue), py::call_guard<py::gil_scoped_release>(), py::arg("player"), py::arg("node"), py::arg("values"))
+        .def("set_value", py::overload_cast<const int&, const GraphNode&, const std::vector<double>&>(&Environment::SetValue), py::call_guard<py::gil_scoped_release>(), py::arg("player"), py::arg("node"), py::arg("values"))
+        .def("get_sparse_strategy", &Environment::GetSparseStrategy, py::call_guard<py::gil_scoped_release>(), py::arg("player"), py::arg("strategy"), py::arg("type_name") = "default", py::arg("threshold") = 0.0)
+        .def("set_sparse_value", &Environment::SetSparseValue, py::call_guard<py::gil_scoped_release>(), py::arg("player"), py::arg("node"), py::arg("values"))
+        .def("export_strategy", &Environment::ExportStrategy, py::call_guard<py::gil_scoped_release>(), py::arg("path"), py::arg("strategy"), py::arg("type_name") = "default", py::arg("threshold") = 0.0, py::arg("codec") = "default", py::arg("num_threads") = 0)
+        .def("save", &Environment::Save, py::call_guard<py::gil_scoped_release>(), py::arg("path"))
+        .def("load", &Environment::Load, py::call_guard<py::gil_scoped_release>(), py::arg("path"));
 
     py::class_<FileEnvironment, Environment, std::shared_ptr<FileEnvironment>>(m, "FileEnv")
-        .def(py::init<const std::string&, const std::string&>(), py::arg("file_name"), py::arg("traverse_type") = "Enumerate");
+        .def(py::init<const std::string&, const std::string&, const int&, const bool&>(), py::call_guard<py::gil_scoped_release>(), py::arg("file_name"), py::arg("traverse_type") = "Enumerate", py::arg("num_threads") = 0, py::arg("keep_infoset_names") = true)
+        .def(py::init([](const int& num_players,
+                         const py::array_t<int, py::array::c_style | py::array::forcecast>& players,
+                         const py::array_t<int, py::array::c_style | py::array::forcecast>& infosets,
+                         const py::array_t<int, py::array::c_style | py::array::forcecast>& next_ptr,
+                         const py::array_t<int, py::array::c_style | py::array::forcecast>& next,
+                         const py::array_t<double, py::array::c_style | py::array::forcecast>& chance,
+                         const py::array_t<double, py::array::c_style | py::array::forcecast>& payoffs,
+                         const std::vector<std::vector<std::string>>& infoset_names,
+                         const std::string& traverse_type) {
+                return std::make_shared<FileEnvironment>(num_players,
+                    std::vector<int>(players.data(), players.data() + players.size()),
+                    std::vector<int>(infosets.data(), infosets.data() + infosets.size()),
+                    std::vector<int>(next_ptr.data(), next_ptr.data() + next_ptr.size()),
+                    std::vector<int>(next.data(), next.data() + next.size()),
+                    std::vector<double>(chance.data(), chance.data() + chance.size()),
+                    std::vector<double>(payoffs.data(), payoffs.data() + payoffs.size()),
+                    infoset_names, traverse_type);
+            }), py::arg("num_players"), py::arg("players"), py::arg("infosets"), py::arg("next_ptr"), py::arg("next"), py::arg("chance"), py::arg("payoffs"),
+                py::arg("infoset_names") = std::vector<std::vector<std::string>>(), py::arg("traverse_type") = "Enumerate")
+        .def("save_binary", &FileEnvironment::SaveBinary, py::call_guard<py::gil_scoped_release>(), py::arg("file_name"));
+
+    py::class_<Leduc, Environment, std::shared_ptr<Leduc>>(m, "LeducEnv")
+        .def(py::init<const int&, const int&, const int&, const std::string&>(), py::call_guard<py::gil_scoped_release>(),
+             py::arg("num_players") = 2, py::arg("num_ranks") = 3, py::arg("num_copies") = 2, py::arg("traverse_type") = "Enumerate");
+
+    py::class_<NFG, Environment, std::shared_ptr<NFG>>(m, "NFGEnv")
+        .def(py::init([](const std::vector<py::array_t<double, py::array::c_style | py::array::forcecast>>& utility_matrices,
+                         const std::string& traverse_type) {
+                std::vector<Tensor> tensors = ToTensors(utility_matrices);
+                py::gil_scoped_release release;
+                return std::make_shared<NFG>(tensors.size(), tensors, traverse_type);
+            }), py::arg("utility_matrices"), py::arg("traverse_type") = "Enumerate");
+
+    py::class_<BatchedEnvironment, std::shared_ptr<BatchedEnvironment>>(m, "BatchedEnv")
+        .def(py::init<const std::vector<std::shared_ptr<Environment>>&, const int&>(), py::arg("environments"), py::arg("num_threads") = 0)
+        .def_static("from_nfg", [](const std::vector<py::array_t<double, py::array::c_style | py::array::forcecast>>& utility_matrices,
+                                   const std::string& traverse_type, const int& num_threads) {
+                std::vector<Tensor> tensors = ToTensors(utility_matrices);
+                py::gil_scoped_release release;
+                return BatchedEnvironment::FromNFG(tensors, traverse_type, num_threads);
+            }, py::arg("utility_matrices"), py::arg("traverse_type") = "Enumerate", py::arg("num_threads") = 0)
+        .def("__len__", &BatchedEnvironment::Size)
+        .def_readonly("environments", &BatchedEnvironment::environments)
+        .def("set_seed", &BatchedEnvironment::SetSeed, py::call_guard<py::gil_scoped_release>(), py::arg("seed"))
+        .def("set_graph", &BatchedEnvironment::SetGraph, py::call_guard<py::gil_scoped_release>(), py::arg("graph"))
+        .def("update", &BatchedEnvironment::Update, py::call_guard<py::gil_scoped_release>(), py::arg("strategy"), py::arg("upd_player") = -1, py::arg("upd_color") = std::vector<int>{-1}, py::arg("traverse_type") = "default")
+        .def("update_strategy", &BatchedEnvironment::UpdateStrategy, py::call_guard<py::gil_scoped_release>(), py::arg("strategy"), py::arg("update_best") = false)
+        .def("run", &BatchedEnvironment::Run, py::call_guard<py::gil_scoped_release>(), py::arg("schedule"), py::arg("iterations"), py::arg("strategy"), py::arg("type_name") = "default", py::arg("eval_every") = 0, py::arg("update_best") = false, py::arg("update_strategy_every") = 1)
+        .def("exploitability", &BatchedEnvironment::Exploitability, py::call_guard<py::gil_scoped_release>(), py::arg("strategy"), py::arg("type_name") = "default")
+        .def("utility", &BatchedEnvironment::Utility, py::call_guard<py::gil_scoped_release>(), py::arg("strategy"), py::arg("type_name") = "default");
+
+    py::class_<ProceduralEnvironment, Environment, std::shared_ptr<ProceduralEnvironment>>(m, "ProceduralEnv");
+
+    py::class_<PokerEnvironment, ProceduralEnvironment, std::shared_ptr<PokerEnvironment>>(m, "PokerEnv")
+        .def(py::init<const int&, const int&, const int&, const int&, const std::vector<int>&, const std::vector<std::vector<int>>&,
+                      const std::vector<int>&, const int&, const bool&, const std::string&>(), py::call_guard<py::gil_scoped_release>(),
+             py::arg("num_players") = 2, py::arg("num_ranks") = 3, py::arg("num_suits") = 2, py::arg("hole_cards") = 1,
+             py::arg("board_cards") = std::vector<int>{0, 1}, py::arg("raise_sizes") = std::vector<std::vector<int>>{{1}, {2}},
+             py::arg("max_raises") = std::vector<int>{2, 2}, py::arg("ante") = 1, py::arg("suit_isomorphism") = true,
+             py::arg("traverse_type") = "Enumerate");
 }
@@ -0,0 +1,25 @@
+import pytest
+
+import LiteEFG
+from LiteEFG.baselines.CFR import graph
+
+def train(traverse_type, evaluate, iterations=300, eval_every=20):
+    alg = graph()
+    env = LiteEFG.PokerEnv(traverse_type=traverse_type)
+    env.set_graph(alg)
+    LiteEFG.set_seed(0)
+
+    results = []
+    for t in range(iterations):
+        alg.update_graph(env)
+        env.update_strategy(alg.current_strategy())
+        if t % eval_every == 0:
+            results.append(evaluate(env, alg.current_strategy()))
+    return results
+
+@pytest.mark.parametrize("traverse_type", ["Enumerate", "External", "Outcome"])
+def test_exploitability_async_during_training(traverse_type):
+    # the background evaluations walk the poker states while update keeps traversing them
+    futures = train(traverse_type, lambda env, strategy: env.exploitability_async(strategy, "avg-iterate"))
+    expected = train(traverse_type, lambda env, strategy: env.exploitability(strategy, "avg-iterate"))
+    assert [future.result() for future in futures] == expected
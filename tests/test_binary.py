@@ -0,0 +1,29 @@
+import os
+
+import numpy as np
+
+import LiteEFG
+
+def test_infoset_names_survive_binary_round_trip(tmp_path):
+    # player 1 moves at the root, player 2 has one unnamed and one named infoset
+    players = np.array([1, 2, 2, 0, 0, 0, 0])
+    infosets = np.array([1, 1, 2, 0, 0, 0, 0])
+    next_ptr = np.array([0, 2, 4, 6, 6, 6, 6, 6])
+    next_node = np.array([1, 2, 3, 4, 5, 6])
+    payoffs = np.array([0, 0, 0, 0, 0, 0, 1, -1, -1, 1, 2, -2, -2, 2], dtype=np.float64)
+    env = LiteEFG.FileEnv(2, players, infosets, next_ptr, next_node, np.zeros(6), payoffs, [[], ["", "b"]])
+    env.save_binary(str(tmp_path / "game.bin"))
+    loaded = LiteEFG.FileEnv(str(tmp_path / "game.bin"))
+    for player in [1, 2]:
+        assert loaded.get_infoset_names(player) == env.get_infoset_names(player)
+
+def test_index_names_survive_binary_round_trip(tmp_path):
+    # without kept names, infosets are named by their indices before and after the round trip
+    file_name = str(tmp_path / "kuhn.bin")
+    env = LiteEFG.FileEnv(os.path.join(os.path.dirname(LiteEFG.__file__), "game_instances", "kuhn.game"), keep_infoset_names=False)
+    env.set_graph(LiteEFG.Graph()) # names the infosets by their indices
+    env.save_binary(file_name)
+    loaded = LiteEFG.FileEnv(file_name)
+    loaded.set_graph(LiteEFG.Graph())
+    for player in [1, 2]:
+        assert loaded.get_infoset_names(player) == env.get_infoset_names(player) == [str(i) for i in range(6)]
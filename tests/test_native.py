@@ -0,0 +1,28 @@
+import os
+
+import pytest
+
+import LiteEFG
+from LiteEFG.baselines import native
+
+GAMES = ["kuhn.game", "leduc.game"]
+
+# CFR, CFRplus and PCFR take no parameters
+PARAMS = [("DCFR", {"alpha": 2.0, "beta": 0.5, "gamma": 3.0}),
+          ("MMD", {"eta": 0.1, "tau": 0.01, "gamma": 0.01, "regularizer": "Euclidean", "feedback": "counterfactual"}),
+          ("QFR", {"eta": 0.1, "tau": 0.01, "gamma": 0.01, "regularizer": "Euclidean", "feedback": "counterfactual"})]
+
+@pytest.mark.parametrize("game", GAMES)
+@pytest.mark.parametrize("name", LiteEFG.kernels())
+def test_native_matches_graph(name, game):
+    # the fused kernel and the graph baseline of the same name give the same exploitability at every iteration
+    file_name = os.path.join(os.path.dirname(LiteEFG.__file__), "game_instances", game)
+    make_env = lambda: LiteEFG.FileEnv(file_name, traverse_type="Enumerate")
+    assert native.compare(name, make_env, iterations=100, type_name=native.convergence_types[name]) < 1e-9
+
+@pytest.mark.parametrize("game", GAMES)
+@pytest.mark.parametrize("name, params", PARAMS)
+def test_native_matches_graph_with_params(name, params, game):
+    file_name = os.path.join(os.path.dirname(LiteEFG.__file__), "game_instances", game)
+    make_env = lambda: LiteEFG.FileEnv(file_name, traverse_type="Enumerate")
+    assert native.compare(name, make_env, iterations=100, type_name=native.convergence_types[name], **params) < 1e-9
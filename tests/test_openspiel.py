@@ -0,0 +1,29 @@
+import os
+
+import pytest
+
+import LiteEFG
+from LiteEFG.baselines.CFR import graph
+
+pyspiel = pytest.importorskip("pyspiel")
+
+GAMES = [("kuhn_poker", "kuhn.game"), ("leduc_poker", "leduc.game")]
+
+def train(env, iterations=50):
+    alg = graph()
+    env.set_graph(alg)
+
+    results = [sum(env.exploitability(alg.current_strategy(), "avg-iterate"))]
+    for t in range(iterations):
+        alg.update_graph(env)
+        env.update_strategy(alg.current_strategy())
+        results.append(sum(env.exploitability(alg.current_strategy(), "avg-iterate")))
+    return results
+
+@pytest.mark.parametrize("game_name, game_file", GAMES)
+def test_openspiel_matches_game_file(game_name, game_file):
+    # the tree exported from OpenSpiel and the bundled game file are the same game, so CFR gives the same exploitability
+    file_name = os.path.join(os.path.dirname(LiteEFG.__file__), "game_instances", game_file)
+    expected = train(LiteEFG.FileEnv(file_name, traverse_type="Enumerate"))
+    result = train(LiteEFG.OpenSpielEnv(pyspiel.load_game(game_name), traverse_type="Enumerate", regenerate=True))
+    assert result == pytest.approx(expected, abs=1e-9)